@@ -0,0 +1,184 @@
+// CAN Transmit Queue
+// RAM ring drained into the FDCAN TX FIFO, see can_tx_queue.h.
+
+#include "can_tx_queue.h"
+
+#include <string.h>
+
+#include "fdcan.h"
+#include "main.h"
+
+#if (CAN_TX_QUEUE_SIZE & (CAN_TX_QUEUE_SIZE - 1U)) != 0 || CAN_TX_QUEUE_SIZE > 128U
+#error "CAN_TX_QUEUE_SIZE must be a power of two, at most 128"
+#endif
+
+// Keeps the frame stores ahead of the head update that hands the slot to
+// drain(), which the TX complete interrupt may run at any point: __DMB() on
+// the Cortex-M, a compiler barrier for host builds (as in deferred_log.c)
+#if defined(__ARM_ARCH)
+#define CAN_TX_QUEUE_BARRIER() __DMB()
+#else
+#define CAN_TX_QUEUE_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+
+typedef struct
+{
+        uint32_t id;
+        uint32_t dlc;    // FDCAN_DLC_BYTES_*
+        bool     fd;     // CAN FD format, classic otherwise
+        uint8_t  data[CAN_TX_QUEUE_MAX_BYTES];
+} can_tx_frame_t;
+
+// Single producer (main loop), and the ring is only drained with the TX
+// complete interrupt masked or from inside it, so head and tail need no lock
+static can_tx_frame_t    ring[CAN_TX_QUEUE_SIZE];
+static volatile uint16_t head = 0; // Next slot written, main loop only
+static volatile uint16_t tail = 0; // Next slot sent, drain() only
+
+// Counts since the last report
+static uint16_t          queued      = 0;
+static uint16_t          overflows   = 0;
+static volatile uint16_t hal_errors  = 0;
+static uint8_t           high_water  = 0;
+static uint16_t          poll_frames = 0;
+
+static void drain(void)
+{
+        FDCAN_TxHeaderTypeDef header = {
+                .IdType              = FDCAN_STANDARD_ID,
+                .TxFrameType         = FDCAN_DATA_FRAME,
+                .ErrorStateIndicator = FDCAN_ESI_ACTIVE,
+                .BitRateSwitch       = FDCAN_BRS_OFF,
+                .TxEventFifoControl  = FDCAN_NO_TX_EVENTS,
+                .MessageMarker       = 0,
+        };
+
+        while (tail != head && HAL_FDCAN_GetTxFifoFreeLevel(&hfdcan1) > 0U)
+        {
+                can_tx_frame_t *frame = &ring[tail % CAN_TX_QUEUE_SIZE];
+
+                header.Identifier = frame->id;
+                header.DataLength = frame->dlc;
+                header.FDFormat   = frame->fd ? FDCAN_FD_CAN : FDCAN_CLASSIC_CAN;
+                if (HAL_FDCAN_AddMessageToTxFifoQ(&hfdcan1, &header, frame->data) != HAL_OK)
+                {
+                        // Left queued; the next send or TX complete retries it
+                        hal_errors++;
+                        break;
+                }
+                tail++;
+        }
+}
+
+void can_tx_queue_init(void)
+{
+        HAL_FDCAN_ActivateNotification(&hfdcan1, FDCAN_IT_TX_COMPLETE, FDCAN_TX_BUFFER0 | FDCAN_TX_BUFFER1 | FDCAN_TX_BUFFER2);
+}
+
+// FDCAN_DLC_BYTES_* for a payload length; false if no DLC codes it exactly
+static bool length_dlc(uint8_t length, uint32_t *dlc)
+{
+        switch (length)
+        {
+                case 8:  *dlc = FDCAN_DLC_BYTES_8;  return true;
+                case 12: *dlc = FDCAN_DLC_BYTES_12; return true;
+                case 16: *dlc = FDCAN_DLC_BYTES_16; return true;
+                case 20: *dlc = FDCAN_DLC_BYTES_20; return true;
+                case 24: *dlc = FDCAN_DLC_BYTES_24; return true;
+                case 32: *dlc = FDCAN_DLC_BYTES_32; return true;
+                case 48: *dlc = FDCAN_DLC_BYTES_48; return true;
+                case 64: *dlc = FDCAN_DLC_BYTES_64; return true;
+                default: return false;
+        }
+}
+
+static bool enqueue(uint32_t id, const uint8_t *data, uint8_t length, bool fd)
+{
+        uint16_t depth = (uint16_t)(head - tail);
+        uint32_t dlc;
+
+        if (length > CAN_TX_QUEUE_MAX_BYTES || !length_dlc(length, &dlc))
+        {
+                return false;
+        }
+
+        if (depth >= CAN_TX_QUEUE_SIZE)
+        {
+                overflows++;
+                return false;
+        }
+
+        can_tx_frame_t *frame = &ring[head % CAN_TX_QUEUE_SIZE];
+        frame->id  = id;
+        frame->dlc = dlc;
+        frame->fd  = fd;
+        memcpy(frame->data, data, length);
+
+        // Publish only once the frame is complete
+        CAN_TX_QUEUE_BARRIER();
+        head++;
+
+        queued++;
+        depth++;
+        high_water = (depth > high_water) ? (uint8_t)depth : high_water;
+
+        // The FIFO may be idle with no TX complete interrupt to come. PRIMASK is
+        // restored rather than cleared, so a caller with interrupts masked keeps them so
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        drain();
+        __set_PRIMASK(primask);
+
+        return true;
+}
+
+bool can_tx_queue_send(uint32_t id, const uint8_t *data)
+{
+        return enqueue(id, data, 8, false);
+}
+
+bool can_tx_queue_send_fd(uint32_t id, const uint8_t *data, uint8_t length)
+{
+        return enqueue(id, data, length, true);
+}
+
+void can_tx_queue_tx_complete(void)
+{
+        drain();
+}
+
+static void send_stats(void)
+{
+        uint16_t errors;
+        uint8_t  data[8];
+        uint32_t primask = __get_PRIMASK();
+
+        __disable_irq();
+        errors     = hal_errors;
+        hal_errors = 0;
+        __set_PRIMASK(primask);
+
+        data[0] = (queued >> 8) & 0xFF;
+        data[1] = queued & 0xFF;
+        data[2] = (overflows >> 8) & 0xFF;
+        data[3] = overflows & 0xFF;
+        data[4] = (errors >> 8) & 0xFF;
+        data[5] = errors & 0xFF;
+        data[6] = high_water;
+        data[7] = (uint8_t)CAN_TX_QUEUE_SIZE;
+
+        queued     = 0;
+        overflows  = 0;
+        high_water = 0;
+
+        can_tx_queue_send(CAN_TX_QUEUE_CAN_STATS, data);
+}
+
+void can_tx_queue_poll(void)
+{
+        if (++poll_frames >= CAN_TX_QUEUE_REPORT_FRAMES)
+        {
+                poll_frames = 0;
+                send_stats();
+        }
+}
@@ -0,0 +1,66 @@
+// CAN Transmit Queue
+// Non-blocking CAN transmit. can_tx_queue_send() copies the frame into
+// a RAM ring and returns at once; frames move from the ring into the FDCAN TX
+// FIFO whenever it has room, from the sender and from the TX complete
+// interrupt. The measurement loop never waits on the bus, and the HAL_Delay()
+// pacing between frames is no longer needed: the FIFO hands frames to the bus
+// in order.
+//
+// A full ring drops the new frame and counts it as an overflow. Counters since
+// the last report are sent every CAN_TX_QUEUE_REPORT_FRAMES calls to
+// can_tx_queue_poll() (big-endian):
+//   0x605 TX STATS  sensor -> host  frames queued (u16), overflows (u16),
+//                                   HAL errors (u16), ring high-water mark (u8),
+//                                   ring size (u8)
+//
+// Integration: call can_tx_queue_init() once FDCAN1 is started,
+// can_tx_queue_tx_complete() from HAL_FDCAN_TxBufferCompleteCallback() in
+// fdcan.c, and can_tx_queue_poll() once per frame from the measurement loop.
+
+#ifndef CAN_TX_QUEUE_H
+#define CAN_TX_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CAN_TX_QUEUE_CAN_STATS (0x605U)
+
+// Frames held in RAM; a power of two, at most 128
+#ifndef CAN_TX_QUEUE_SIZE
+#define CAN_TX_QUEUE_SIZE (32U)
+#endif
+
+// Largest payload queued; CAN FD frames above 8 bytes need a larger value
+#ifndef CAN_TX_QUEUE_MAX_BYTES
+#if defined(CAN_FD_BURST)
+#define CAN_TX_QUEUE_MAX_BYTES (64U)
+#elif defined(CAN_FD_TELEMETRY)
+#define CAN_TX_QUEUE_MAX_BYTES (32U)
+#else
+#define CAN_TX_QUEUE_MAX_BYTES (8U)
+#endif
+#endif
+
+#ifndef CAN_TX_QUEUE_REPORT_FRAMES
+#define CAN_TX_QUEUE_REPORT_FRAMES (50U)
+#endif
+
+// Enables the TX complete interrupt on FDCAN1
+void can_tx_queue_init(void);
+
+// Queue an 8-byte classic standard-id frame. Returns false if the ring was
+// full and the frame was dropped.
+bool can_tx_queue_send(uint32_t id, const uint8_t *data);
+
+// Queue a CAN FD frame (no bit rate switch) of length bytes: 8, 12, 16, 20,
+// 24, 32, 48 or 64, at most CAN_TX_QUEUE_MAX_BYTES. Needs FDCAN1 set up for
+// an FD frame format. Returns false if the frame was dropped.
+bool can_tx_queue_send_fd(uint32_t id, const uint8_t *data, uint8_t length);
+
+// Interrupt context: move queued frames into the freed TX FIFO slots
+void can_tx_queue_tx_complete(void);
+
+// Main loop, once per frame: sends the statistics when due
+void can_tx_queue_poll(void);
+
+#endif // CAN_TX_QUEUE_H
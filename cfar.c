@@ -0,0 +1,122 @@
+// CA-CFAR
+// Running-sum cell-averaging CFAR, see cfar.h.
+
+#include "cfar.h"
+
+#include <stdbool.h>
+
+#include "power_kernel.h"
+
+#define CFAR_WINDOW (CFAR_GUARD_CELLS + CFAR_TRAINING_CELLS)
+#define CFAR_RING   (2U * CFAR_WINDOW + 2U)
+
+typedef struct
+{
+        const acc_int16_complex_t *data;
+        uint16_t                  num_points;
+        uint16_t                  sweeps;
+        uint32_t                  ring[CFAR_RING]; // Power of bin b at ring[b % CFAR_RING]
+} cfar_frame_t;
+
+static uint32_t load_bin(cfar_frame_t *frame, int32_t bin)
+{
+        uint32_t power;
+
+        power_kernel_integrate(&frame->data[bin], frame->num_points, frame->sweeps, &power, 1);
+        frame->ring[bin % CFAR_RING] = power;
+        return power;
+}
+
+static bool in_frame(const cfar_frame_t *frame, int32_t bin)
+{
+        return (bin >= 0) && (bin < frame->num_points);
+}
+
+CfarCrossing cfar_find_crossing(const acc_int16_complex_t *data, uint16_t num_points, uint16_t sweeps,
+                                uint16_t first_bin, uint16_t last_bin)
+{
+        CfarCrossing crossing = { -1, 0, 0, 0, 0 };
+        cfar_frame_t frame    = { data, num_points, sweeps, { 0 } };
+        uint64_t     lag_sum  = 0; // Training cells before the cell under test
+        uint64_t     lead_sum = 0; // Training cells after it
+        uint32_t     lag_n    = 0;
+        uint32_t     lead_n   = 0;
+
+        first_bin = (first_bin < 1) ? 1 : first_bin;
+        if (num_points < 2 || first_bin > last_bin || first_bin >= num_points)
+        {
+                return crossing;
+        }
+        last_bin = (last_bin >= num_points) ? num_points - 1 : last_bin;
+
+        // Fill the ring around the first cell under test
+        for (int32_t bin = (int32_t)first_bin - (int32_t)CFAR_WINDOW; bin <= (int32_t)first_bin + (int32_t)CFAR_WINDOW; bin++)
+        {
+                if (!in_frame(&frame, bin))
+                {
+                        continue;
+                }
+
+                uint32_t power = load_bin(&frame, bin);
+                int32_t  dist  = bin - (int32_t)first_bin;
+
+                if (dist < -(int32_t)CFAR_GUARD_CELLS)
+                {
+                        lag_sum += power;
+                        lag_n++;
+                }
+                else if (dist > (int32_t)CFAR_GUARD_CELLS)
+                {
+                        lead_sum += power;
+                        lead_n++;
+                }
+        }
+
+        for (int32_t i = first_bin; i <= (int32_t)last_bin; i++)
+        {
+                uint32_t power    = frame.ring[i % CFAR_RING];
+                uint32_t cells    = lag_n + lead_n;
+                uint64_t training = lag_sum + lead_sum;
+
+                crossing.max_power = (power > crossing.max_power) ? power : crossing.max_power;
+
+                // power > scale * training / cells, without the divide
+                if (cells > 0 && (uint64_t)power * cells * 256U > (uint64_t)CFAR_SCALE_Q8 * training)
+                {
+                        crossing.index      = i;
+                        crossing.power      = power;
+                        crossing.prev_power = frame.ring[(i - 1) % CFAR_RING];
+                        crossing.threshold  = (uint32_t)(((uint64_t)CFAR_SCALE_Q8 * training) / ((uint64_t)cells * 256U));
+                        return crossing;
+                }
+
+                // Slide both training windows by one bin
+                int32_t lag_in   = i - (int32_t)CFAR_GUARD_CELLS;
+                int32_t lag_out  = i - (int32_t)CFAR_WINDOW;
+                int32_t lead_out = i + (int32_t)CFAR_GUARD_CELLS + 1;
+                int32_t lead_in  = i + (int32_t)CFAR_WINDOW + 1;
+
+                if (in_frame(&frame, lag_in))
+                {
+                        lag_sum += frame.ring[lag_in % CFAR_RING];
+                        lag_n++;
+                }
+                if (in_frame(&frame, lag_out))
+                {
+                        lag_sum -= frame.ring[lag_out % CFAR_RING];
+                        lag_n--;
+                }
+                if (in_frame(&frame, lead_out))
+                {
+                        lead_sum -= frame.ring[lead_out % CFAR_RING];
+                        lead_n--;
+                }
+                if (in_frame(&frame, lead_in))
+                {
+                        lead_sum += load_bin(&frame, lead_in);
+                        lead_n++;
+                }
+        }
+
+        return crossing;
+}
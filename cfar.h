@@ -0,0 +1,56 @@
+// CA-CFAR
+// Cell-averaging constant false alarm rate detection over the integrated power
+// of one frame. Each bin is compared with the mean power of the training cells
+// on both sides of it, skipping the guard cells next to it, so the threshold
+// follows the local clutter instead of hand-tuned threshold lines.
+//
+// The training sums are running sums updated by one bin on each side per step,
+// and bin powers live in a ring of 2 * (guard + training) + 2 entries, so a
+// frame is O(N) with no frame-sized buffers. Near the ends of the sweep the
+// mean is taken over the training cells that exist.
+//
+// A bin is detected when power > CFAR_SCALE * mean(training power). Tuning
+// (compile time, like LOOKUP_TABLE_* and LUT_DOWNLOAD_MAX_SIZE):
+//   CFAR_GUARD_CELLS     bins skipped on each side of the cell under test
+//   CFAR_TRAINING_CELLS  bins averaged on each side
+//   CFAR_SCALE_Q8        CFAR_SCALE * 256; about 12 gives Pfa ~1e-4 with
+//                        16 training cells on a square-law detector
+
+#ifndef CFAR_H
+#define CFAR_H
+
+#include <stdint.h>
+
+#include "acc_definitions_common.h"
+
+#ifndef CFAR_GUARD_CELLS
+#define CFAR_GUARD_CELLS (2U)
+#endif
+
+#ifndef CFAR_TRAINING_CELLS
+#define CFAR_TRAINING_CELLS (8U)
+#endif
+
+#ifndef CFAR_SCALE_Q8
+#define CFAR_SCALE_Q8 (12U * 256U)
+#endif
+
+// Powers are summed over the sweeps, see power_kernel_integrate()
+typedef struct
+{
+        int32_t  index;      // First bin above its CFAR threshold, -1 if none
+        uint32_t power;      // Power at index
+        uint32_t prev_power; // Power at index - 1
+        uint32_t threshold;  // CFAR power threshold at index
+        uint32_t max_power;  // Highest power in the bins tested
+} CfarCrossing;
+
+// Scan bins first_bin..last_bin (clamped to 1..num_points-1, so there is always
+// a bin before the crossing to interpolate from) of a frame of
+// num_points * sweeps samples, power summed over the sweeps (the sweep count
+// cancels in the CFAR ratio, so it is never divided out). Stops at the
+// first detection.
+CfarCrossing cfar_find_crossing(const acc_int16_complex_t *data, uint16_t num_points, uint16_t sweeps,
+                                uint16_t first_bin, uint16_t last_bin);
+
+#endif // CFAR_H
@@ -0,0 +1,178 @@
+// CA-CFAR Benchmark
+// Host benchmark of cfar_find_crossing() on 400-point frames against the frame
+// budget (1 / CFAR_BENCH_FRAME_RATE_HZ), for 1 to 16 sweeps per frame. Half of
+// the frames are noise only, so the scan runs over every bin: the worst case.
+// Each result is cross-checked against a direct O(N * training) CA-CFAR.
+//
+// This times the host, not the MCU: the budget column is the headroom a slower
+// core has to fit in, not a measurement of the target. The max column includes
+// any preemption by the host OS; p99 is the steadier worst case.
+//
+// Build and run (the include path is the Acconeer RSS include directory):
+//   gcc -O2 -I<rss>/include cfar_bench.c cfar.c power_kernel.c -o cfar_bench && ./cfar_bench
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cfar.h"
+#include "power_kernel.h"
+
+#ifndef CFAR_BENCH_FRAME_RATE_HZ
+#define CFAR_BENCH_FRAME_RATE_HZ (200U)
+#endif
+
+#define BENCH_POINTS     (400U)
+#define BENCH_MAX_SWEEPS (16U)
+#define BENCH_FRAMES     (2000U)
+
+static double now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int16_t noise(int amplitude)
+{
+        // Sum of uniforms, close enough to Gaussian clutter for timing
+        int sum = 0;
+
+        for (int k = 0; k < 4; k++)
+        {
+                sum += rand() % (2 * amplitude + 1) - amplitude;
+        }
+        return (int16_t)(sum / 2);
+}
+
+static void fill_frame(acc_int16_complex_t *data, uint16_t sweeps, int target_bin)
+{
+        for (uint16_t s = 0; s < sweeps; s++)
+        {
+                for (uint16_t j = 0; j < BENCH_POINTS; j++)
+                {
+                        acc_int16_complex_t *sample = &data[s * BENCH_POINTS + j];
+                        int                 boost  = (target_bin >= 0 && abs(j - target_bin) <= 1) ? 2000 : 0;
+
+                        sample->real = (int16_t)(noise(200) + boost);
+                        sample->imag = (int16_t)(noise(200) + boost / 2);
+                }
+        }
+}
+
+// Direct CA-CFAR: every training cell summed again for every cell under test
+static CfarCrossing reference_crossing(const acc_int16_complex_t *data, uint16_t sweeps, uint16_t first_bin,
+                                       uint16_t last_bin)
+{
+        CfarCrossing crossing = { -1, 0, 0, 0, 0 };
+        uint32_t     power[BENCH_POINTS];
+
+        power_kernel_integrate(data, BENCH_POINTS, sweeps, power, BENCH_POINTS);
+        first_bin = (first_bin < 1) ? 1 : first_bin;
+        last_bin  = (last_bin >= BENCH_POINTS) ? BENCH_POINTS - 1 : last_bin;
+
+        for (int32_t i = first_bin; i <= (int32_t)last_bin; i++)
+        {
+                uint64_t training = 0;
+                uint32_t cells    = 0;
+
+                for (int32_t d = CFAR_GUARD_CELLS + 1; d <= (int32_t)(CFAR_GUARD_CELLS + CFAR_TRAINING_CELLS); d++)
+                {
+                        if (i - d >= 0)
+                        {
+                                training += power[i - d];
+                                cells++;
+                        }
+                        if (i + d < (int32_t)BENCH_POINTS)
+                        {
+                                training += power[i + d];
+                                cells++;
+                        }
+                }
+
+                crossing.max_power = (power[i] > crossing.max_power) ? power[i] : crossing.max_power;
+                if (cells > 0 && (uint64_t)power[i] * cells * 256U > (uint64_t)CFAR_SCALE_Q8 * training)
+                {
+                        crossing.index      = i;
+                        crossing.power      = power[i];
+                        crossing.prev_power = power[i - 1];
+                        crossing.threshold  = (uint32_t)(((uint64_t)CFAR_SCALE_Q8 * training) / ((uint64_t)cells * 256U));
+                        return crossing;
+                }
+        }
+
+        return crossing;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+        double x = *(const double *)a;
+        double y = *(const double *)b;
+
+        return (x > y) - (x < y);
+}
+
+static bool same_crossing(const CfarCrossing *a, const CfarCrossing *b)
+{
+        return a->index == b->index && a->power == b->power && a->prev_power == b->prev_power &&
+               a->threshold == b->threshold && a->max_power == b->max_power;
+}
+
+int main(void)
+{
+        static const uint16_t      sweep_counts[] = {1, 4, 16};
+        static acc_int16_complex_t data[BENCH_POINTS * BENCH_MAX_SWEEPS];
+        static double              frame_ns[BENCH_FRAMES];
+        const double               budget_ns = 1e9 / CFAR_BENCH_FRAME_RATE_HZ;
+        int                        failed    = 0;
+
+        srand(1);
+        printf("%d points, budget %.0f us per frame (%u Hz)\n", BENCH_POINTS, budget_ns / 1000.0,
+               (unsigned)CFAR_BENCH_FRAME_RATE_HZ);
+        printf("%6s %10s %10s %10s %14s %10s\n", "sweeps", "avg us", "p99 us", "max us", "p99 % budget", "detected");
+
+        for (size_t s = 0; s < sizeof(sweep_counts) / sizeof(sweep_counts[0]); s++)
+        {
+                uint16_t sweeps   = sweep_counts[s];
+                double   total_ns = 0.0;
+                uint32_t detected = 0;
+
+                for (uint32_t f = 0; f < BENCH_FRAMES; f++)
+                {
+                        int target_bin = (f % 2 == 0) ? -1 : (int)(rand() % BENCH_POINTS);
+
+                        fill_frame(data, sweeps, target_bin);
+
+                        double       start    = now_ns();
+                        CfarCrossing crossing = cfar_find_crossing(data, BENCH_POINTS, sweeps, 0, BENCH_POINTS - 1);
+
+                        frame_ns[f] = now_ns() - start;
+                        total_ns   += frame_ns[f];
+                        detected   += (crossing.index >= 0);
+
+                        CfarCrossing expected = reference_crossing(data, sweeps, 0, BENCH_POINTS - 1);
+                        if (!same_crossing(&crossing, &expected))
+                        {
+                                printf("sweeps %u frame %u: index %d, reference %d\n", (unsigned)sweeps, (unsigned)f,
+                                       (int)crossing.index, (int)expected.index);
+                                failed = 1;
+                        }
+                }
+
+                qsort(frame_ns, BENCH_FRAMES, sizeof(frame_ns[0]), compare_double);
+                double p99_ns = frame_ns[BENCH_FRAMES * 99 / 100];
+
+                printf("%6u %10.2f %10.2f %10.2f %13.3f%% %10u\n", (unsigned)sweeps, total_ns / BENCH_FRAMES / 1000.0,
+                       p99_ns / 1000.0, frame_ns[BENCH_FRAMES - 1] / 1000.0, 100.0 * p99_ns / budget_ns,
+                       (unsigned)detected);
+        }
+
+        if (failed)
+        {
+                printf("FAILED: cfar_find_crossing() disagrees with the direct CA-CFAR\n");
+                return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+// Coarse-to-Fine Subsweeps
+// Subsweep layout for the coarse-to-fine detector, see coarse_fine.h.
+
+#include "coarse_fine.h"
+
+static int32_t coarse_step(const PrintDataConfig *print_data_config)
+{
+        return (print_data_config->step > COARSE_FINE_COARSE_STEP) ? print_data_config->step : COARSE_FINE_COARSE_STEP;
+}
+
+void coarse_fine_subsweeps(const PrintDataConfig *print_data_config, int32_t fine_start,
+                           PrintDataConfig *coarse, PrintDataConfig *fine)
+{
+        int32_t span = (int32_t)print_data_config->num_points * print_data_config->step;
+        int32_t step = coarse_step(print_data_config);
+
+        *coarse            = *print_data_config;
+        coarse->step       = (uint16_t)step;
+        coarse->num_points = (uint16_t)((span + step - 1) / step);
+
+        *fine             = *print_data_config;
+        fine->start_point = fine_start;
+        fine->step        = 1;
+        fine->num_points  = COARSE_FINE_FINE_POINTS;
+}
+
+int32_t coarse_fine_fine_start(const PrintDataConfig *print_data_config, int32_t target_point)
+{
+        int32_t first = print_data_config->start_point;
+        int32_t last  = first + (int32_t)print_data_config->num_points * print_data_config->step - (int32_t)COARSE_FINE_FINE_POINTS;
+        int32_t start = target_point - (int32_t)COARSE_FINE_FINE_POINTS / 2;
+
+        start = (start > last) ? last : start;
+        start = (start < first) ? first : start;
+        return start;
+}
+
+bool coarse_fine_covers(int32_t fine_start, int32_t target_point)
+{
+        return (target_point >= fine_start + (int32_t)COARSE_FINE_EDGE_POINTS) &&
+               (target_point < fine_start + (int32_t)COARSE_FINE_FINE_POINTS - (int32_t)COARSE_FINE_EDGE_POINTS);
+}
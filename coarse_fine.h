@@ -0,0 +1,52 @@
+// Coarse-to-Fine Subsweeps
+// Splits the configured range into two subsweeps per sweep: a coarse one over
+// the whole range with a large step to find the target, and a short fine one
+// with step 1 placed around the target for the sub-bin interpolation. The
+// coarse subsweep alone decides whether something was detected; the fine one
+// only refines where.
+//
+// The fine subsweep follows the target from frame to frame. It is moved, by
+// re-preparing the sensor, when the target comes within COARSE_FINE_EDGE_POINTS
+// of either end of it.
+//
+// Point counts per sweep are num_points * step / COARSE_FINE_COARSE_STEP plus
+// COARSE_FINE_FINE_POINTS, instead of num_points.
+
+#ifndef COARSE_FINE_H
+#define COARSE_FINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "print_data_config.h"
+
+// Step length of the coarse subsweep; must be a step length the A121 accepts
+// (1, 2, 3, 4, 6, 8, 12, 24 or a multiple of 24)
+#ifndef COARSE_FINE_COARSE_STEP
+#define COARSE_FINE_COARSE_STEP (8U)
+#endif
+
+// Points of the fine subsweep (step 1)
+#ifndef COARSE_FINE_FINE_POINTS
+#define COARSE_FINE_FINE_POINTS (48U)
+#endif
+
+#ifndef COARSE_FINE_EDGE_POINTS
+#define COARSE_FINE_EDGE_POINTS (12U)
+#endif
+
+#define COARSE_FINE_SUBSWEEP_COARSE (0U)
+#define COARSE_FINE_SUBSWEEP_FINE   (1U)
+
+// Per-subsweep copies of the configuration: the coarse subsweep over the whole
+// configured range, the fine subsweep starting at fine_start
+void coarse_fine_subsweeps(const PrintDataConfig *print_data_config, int32_t fine_start,
+                           PrintDataConfig *coarse, PrintDataConfig *fine);
+
+// Start of a fine subsweep centred on target_point, kept inside the configured range
+int32_t coarse_fine_fine_start(const PrintDataConfig *print_data_config, int32_t target_point);
+
+// True if target_point is far enough inside the fine subsweep at fine_start
+bool coarse_fine_covers(int32_t fine_start, int32_t target_point);
+
+#endif // COARSE_FINE_H
@@ -0,0 +1,110 @@
+// Deferred Log
+// Message ring drained over CAN or printf(), see deferred_log.h.
+
+#include "deferred_log.h"
+
+#include <stdio.h>
+
+#include "can_tx_queue.h"
+#include "main.h"
+
+#if (DEFERRED_LOG_SIZE & (DEFERRED_LOG_SIZE - 1U)) != 0 || DEFERRED_LOG_SIZE > 256U
+#error "DEFERRED_LOG_SIZE must be a power of two, at most 256"
+#endif
+
+// Keeps the entry accesses on the right side of the head and tail updates
+// that hand the slot over: __DMB() on the Cortex-M, where the consumer may run
+// in another context, and a compiler barrier for single-context host builds.
+#if defined(__ARM_ARCH)
+#define DEFERRED_LOG_BARRIER() __DMB()
+#else
+#define DEFERRED_LOG_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+
+typedef struct
+{
+        uint8_t  id;
+        uint8_t  dropped; // Entries lost to a full ring just before this one
+        uint16_t tick;
+        uint32_t arg;
+} deferred_log_entry_t;
+
+static deferred_log_entry_t ring[DEFERRED_LOG_SIZE];
+static volatile uint16_t    head    = 0; // Next slot written, producer only
+static volatile uint16_t    tail    = 0; // Next slot shipped, consumer only
+static uint8_t              dropped = 0; // Producer only
+
+#ifdef DEFERRED_LOG_PRINTF
+#define DEFERRED_LOG_FORMAT(name, level, format) format,
+
+static const char *const formats[DEFERRED_LOG_COUNT] = {
+        DEFERRED_LOG_MESSAGES(DEFERRED_LOG_FORMAT)
+};
+#endif
+
+void deferred_log_write(deferred_log_id_t id, uint32_t arg)
+{
+        if ((uint16_t)(head - tail) >= DEFERRED_LOG_SIZE)
+        {
+                dropped = (dropped < UINT8_MAX) ? dropped + 1U : dropped;
+                return;
+        }
+
+        deferred_log_entry_t *entry = &ring[head % DEFERRED_LOG_SIZE];
+        entry->id      = (uint8_t)id;
+        entry->dropped = dropped;
+        entry->tick    = (uint16_t)HAL_GetTick();
+        entry->arg     = arg;
+        dropped        = 0;
+
+        // Publish only once the entry is complete
+        DEFERRED_LOG_BARRIER();
+        head++;
+}
+
+static bool ship(const deferred_log_entry_t *entry)
+{
+#ifdef DEFERRED_LOG_PRINTF
+        if (entry->dropped > 0)
+        {
+                printf("(%u log messages dropped)\n", (unsigned)entry->dropped);
+        }
+        printf(formats[entry->id], (unsigned)entry->arg);
+        printf("\n");
+        return true;
+#else
+        uint8_t data[8];
+
+        data[0] = entry->id;
+        data[1] = entry->dropped;
+        data[2] = (entry->tick >> 8) & 0xFF;
+        data[3] = entry->tick & 0xFF;
+        data[4] = (entry->arg >> 24) & 0xFF;
+        data[5] = (entry->arg >> 16) & 0xFF;
+        data[6] = (entry->arg >> 8) & 0xFF;
+        data[7] = entry->arg & 0xFF;
+
+        return can_tx_queue_send(DEFERRED_LOG_CAN_ID, data);
+#endif
+}
+
+void deferred_log_poll(void)
+{
+        uint16_t published = head;
+
+        // Entries up to published are complete before any of them is read
+        DEFERRED_LOG_BARRIER();
+
+        for (uint16_t n = 0; n < DEFERRED_LOG_DRAIN_MAX && tail != published; n++)
+        {
+                // A full CAN queue keeps the entry for the next poll
+                if (!ship(&ring[tail % DEFERRED_LOG_SIZE]))
+                {
+                        break;
+                }
+
+                // Done reading the slot before the producer may reuse it
+                DEFERRED_LOG_BARRIER();
+                tail++;
+        }
+}
@@ -0,0 +1,85 @@
+// Deferred Log
+// printf() goes out over a blocking UART/ITM retarget, which shows up as
+// jitter in the frame timing when it runs in the measurement loop. Instead
+// the loop logs with DEFERRED_LOG(), which only stores the message id, the
+// tick and one 32-bit argument in a RAM ring. deferred_log_poll(), called
+// once per frame where the loop has slack, ships up to DEFERRED_LOG_DRAIN_MAX
+// entries over CAN (big-endian):
+//   0x620 LOG  sensor -> host  message id (u8), messages dropped before this
+//                              one (u8, saturating), tick (u16, ms, low bits),
+//                              argument (u32)
+// deferred_log.py turns ids back into text from the DEFERRED_LOG_MESSAGES
+// table below, so ids are the table order: only ever append to it. With
+// DEFERRED_LOG_PRINTF the drain formats the messages with printf() instead,
+// for a bench setup with a console and no CAN host.
+//
+// Messages below DEFERRED_LOG_LEVEL compile out. The ring is lock-free with
+// one producer, the main loop, and one consumer, deferred_log_poll(), which
+// may also run from a lower-priority context; do not log from interrupts.
+
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DEFERRED_LOG_CAN_ID (0x620U)
+
+#define DEFERRED_LOG_LEVEL_DEBUG (0)
+#define DEFERRED_LOG_LEVEL_INFO  (1)
+#define DEFERRED_LOG_LEVEL_WARN  (2)
+#define DEFERRED_LOG_LEVEL_ERROR (3)
+
+// Lowest level logged; DEBUG adds a message per frame
+#ifndef DEFERRED_LOG_LEVEL
+#define DEFERRED_LOG_LEVEL DEFERRED_LOG_LEVEL_INFO
+#endif
+
+// Entries held in RAM; a power of two, at most 256
+#ifndef DEFERRED_LOG_SIZE
+#define DEFERRED_LOG_SIZE (32U)
+#endif
+
+// Entries shipped per deferred_log_poll()
+#ifndef DEFERRED_LOG_DRAIN_MAX
+#define DEFERRED_LOG_DRAIN_MAX (4U)
+#endif
+
+// X(name, level, printf format with at most one argument)
+#define DEFERRED_LOG_MESSAGES(X) \
+        X(SYNC,               DEBUG, "sync")                                                     \
+        X(CAN_TX_FULL,        WARN,  "CAN TX queue full, frame 0x%x dropped")                     \
+        X(CALIBRATION_NEEDED, INFO,  "The current calibration is not valid for the current temperature, re-calibrating") \
+        X(RECALIBRATED,       INFO,  "The sensor was successfully re-calibrated")
+
+#define DEFERRED_LOG_ID(name, level, format)    DEFERRED_LOG_##name,
+#define DEFERRED_LOG_LEVELS(name, level, format) DEFERRED_LOG_##name##_LEVEL = DEFERRED_LOG_LEVEL_##level,
+
+typedef enum
+{
+        DEFERRED_LOG_MESSAGES(DEFERRED_LOG_ID)
+        DEFERRED_LOG_COUNT
+} deferred_log_id_t;
+
+enum
+{
+        DEFERRED_LOG_MESSAGES(DEFERRED_LOG_LEVELS)
+};
+
+// Log message DEFERRED_LOG_<name> with one argument (0 if the format has none)
+#define DEFERRED_LOG(name, arg)                                                  \
+        do                                                                       \
+        {                                                                        \
+                if (DEFERRED_LOG_##name##_LEVEL >= DEFERRED_LOG_LEVEL)           \
+                {                                                                \
+                        deferred_log_write(DEFERRED_LOG_##name, (uint32_t)(arg)); \
+                }                                                                \
+        } while (0)
+
+// Store one entry; counts it as dropped if the ring is full
+void deferred_log_write(deferred_log_id_t id, uint32_t arg);
+
+// Ship up to DEFERRED_LOG_DRAIN_MAX entries
+void deferred_log_poll(void);
+
+#endif // DEFERRED_LOG_H
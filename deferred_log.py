@@ -0,0 +1,73 @@
+"""
+Deferred Log Decoder
+Turns the 0x620 messages of deferred_log.c (forwarded by the serial bridge)
+back into text. The sensor only sends a message id and one argument; the
+text comes from the DEFERRED_LOG_MESSAGES table in deferred_log.h, so the
+decoder always matches the header it is given.
+"""
+
+import re
+import struct
+
+# Serial frame type the bridge uses for 0x620 log messages
+DEFERRED_LOG_FRAME = 0xA6
+
+_ENTRY = re.compile(r'X\(\s*(\w+)\s*,\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+_CONVERSION = re.compile(r'%%|%[-+ #0]*\d*[diuxXc]')
+
+
+def parse_messages(header_path):
+    """
+    Read the message table from deferred_log.h.
+
+    Returns:
+        list of (name, level, format), indexed by message id
+    """
+    with open(header_path) as f:
+        text = f.read()
+    start = text.index('#define DEFERRED_LOG_MESSAGES(X)')
+    end = text.index('\n\n', start)
+    return _ENTRY.findall(text[start:end])
+
+
+def parse_entry(payload):
+    """Decode a 0x620 payload into a dict"""
+    msg_id, dropped, tick, arg = struct.unpack('>BBHI', payload[0:8])
+    return {"id": msg_id, "dropped": dropped, "tick": tick, "arg": arg}
+
+
+class DeferredLogDecoder:
+    def __init__(self, header_path):
+        try:
+            self.messages = parse_messages(header_path)
+        except (OSError, ValueError) as e:
+            print(f"Deferred log table not loaded ({e}), printing raw ids")
+            self.messages = []
+
+    def format(self, entry):
+        """Text of one entry, formatted as printf() would on the sensor"""
+        if entry["id"] >= len(self.messages):
+            return f"unknown message {entry['id']} arg=0x{entry['arg']:08x}"
+
+        name, level, fmt = self.messages[entry["id"]]
+        arg = entry["arg"]
+
+        def convert(match):
+            spec = match.group(0)
+            if spec == '%%':
+                return '%'
+            if spec[-1] in 'di':
+                return (spec % (arg - (1 << 32) if arg & 0x80000000 else arg))
+            if spec[-1] == 'c':
+                return chr(arg & 0xFF)
+            return spec.replace('u', 'd') % arg
+
+        return f"{level} {_CONVERSION.sub(convert, fmt)}"
+
+    def decode(self, payload):
+        """Text of a 0x620 payload, with the tick and any messages lost before it"""
+        entry = parse_entry(payload)
+        text = f"t={entry['tick']:5d} {self.format(entry)}"
+        if entry["dropped"]:
+            text += f" ({entry['dropped']} dropped before)"
+        return text
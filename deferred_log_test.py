@@ -0,0 +1,77 @@
+"""
+Deferred Log Decoder Test
+Host round trip for deferred_log.py: entries are packed the way
+deferred_log.c ships them on 0x620 and must decode to the text of the
+DEFERRED_LOG_MESSAGES table in deferred_log.h.
+
+Run:
+    python3 deferred_log_test.py
+"""
+
+import os
+import struct
+import tempfile
+import unittest
+
+from deferred_log import DeferredLogDecoder, parse_entry, parse_messages
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "deferred_log.h")
+
+
+def encode(msg_id, dropped, tick, arg):
+    """0x620 payload as ship() in deferred_log.c builds it"""
+    return struct.pack('>BBHI', msg_id, dropped, tick & 0xFFFF, arg)
+
+
+class DeferredLogTest(unittest.TestCase):
+    def setUp(self):
+        self.decoder = DeferredLogDecoder(HEADER)
+        self.ids = {name: i for i, (name, _, _) in enumerate(self.decoder.messages)}
+
+    def test_table_order(self):
+        # Ids are the table order, which deferred_log.h says to only append to
+        names = [name for name, _, _ in parse_messages(HEADER)]
+        self.assertEqual(names[:4], ["SYNC", "CAN_TX_FULL", "CALIBRATION_NEEDED", "RECALIBRATED"])
+
+    def test_entry_round_trip(self):
+        for msg_id, dropped, tick, arg in [(0, 0, 0, 0), (3, 255, 65535, 0xFFFFFFFF), (1, 7, 1234, 0x16)]:
+            entry = parse_entry(encode(msg_id, dropped, tick, arg))
+            self.assertEqual(entry, {"id": msg_id, "dropped": dropped, "tick": tick, "arg": arg})
+
+    def test_decode_text(self):
+        payload = encode(self.ids["CAN_TX_FULL"], 0, 42, 0x16)
+        self.assertEqual(self.decoder.decode(payload), "t=   42 WARN CAN TX queue full, frame 0x16 dropped")
+
+        payload = encode(self.ids["RECALIBRATED"], 3, 65535, 0)
+        self.assertEqual(self.decoder.decode(payload),
+                         "t=65535 INFO The sensor was successfully re-calibrated (3 dropped before)")
+
+    def test_every_message_decodes(self):
+        for name, level, _ in self.decoder.messages:
+            text = self.decoder.decode(encode(self.ids[name], 0, 1, 5))
+            self.assertIn(f" {level} ", text)
+            self.assertNotIn("unknown message", text)
+
+    def test_unknown_id(self):
+        payload = encode(len(self.decoder.messages), 0, 0, 0xABCD)
+        self.assertIn("unknown message", self.decoder.decode(payload))
+
+    def test_conversions(self):
+        # A table using the other printf conversions the decoder handles
+        with tempfile.NamedTemporaryFile("w", suffix=".h", delete=False) as f:
+            f.write('#define DEFERRED_LOG_MESSAGES(X) \\\n'
+                    '        X(SIGNED,  INFO, "delta %d mm") \\\n'
+                    '        X(PERCENT, INFO, "load %u%%") \\\n'
+                    '        X(CHAR,    INFO, "state %c")\n\n')
+        try:
+            decoder = DeferredLogDecoder(f.name)
+        finally:
+            os.unlink(f.name)
+
+        self.assertEqual(decoder.format(parse_entry(encode(0, 0, 0, (-5) & 0xFFFFFFFF))), "INFO delta -5 mm")
+        self.assertEqual(decoder.format(parse_entry(encode(1, 0, 0, 80))), "INFO load 80%")
+        self.assertEqual(decoder.format(parse_entry(encode(2, 0, 0, ord('R')))), "INFO state R")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,233 @@
+// Detection Plan
+// Precomputed per-bin thresholds, see detection_plan.h.
+
+#include "detection_plan.h"
+
+#include <string.h>
+
+#include "power_kernel.h"
+
+// Bins per power_kernel() call in detection_plan_find_crossing()
+#define DETECTION_PLAN_BLOCK (32U)
+
+static void make_key(DetectionPlanKey *key, const PrintDataConfig *print_data_config)
+{
+        // Zeroed first so padding does not break the memcmp() in detection_plan_is_stale()
+        memset(key, 0, sizeof(*key));
+
+        key->rf_factor   = print_data_config->rf_factor;
+        key->step        = print_data_config->step;
+        key->start_point = print_data_config->start_point;
+        key->start       = print_data_config->start;
+        key->num_points  = print_data_config->num_points;
+        memcpy(key->x_intercepts, print_data_config->x_intercepts, sizeof(key->x_intercepts));
+        key->slopes[0]     = print_data_config->line1_slope;
+        key->slopes[1]     = print_data_config->line2_slope;
+        key->slopes[2]     = print_data_config->line3_slope;
+        key->intercepts[0] = print_data_config->y_inter_line1;
+        key->intercepts[1] = print_data_config->y_inter_line2;
+        key->intercepts[2] = print_data_config->y_inter_line3;
+}
+
+bool detection_plan_set_segments(DetectionPlan *plan, const DetectionSegment *segments, uint16_t segment_count)
+{
+        if (segment_count > DETECTION_PLAN_MAX_SEGMENTS)
+        {
+                return false;
+        }
+
+        memcpy(plan->segments, segments, segment_count * sizeof(DetectionSegment));
+        plan->segment_count = segment_count;
+        plan->divisor       = 0;
+
+        for (uint16_t i = 0; i < plan->num_points; i++)
+        {
+                float distance  = detection_plan_distance(plan, i);
+                float threshold = 0;
+
+                for (uint16_t s = 0; s < segment_count; s++)
+                {
+                        const DetectionSegment *segment = &segments[s];
+                        bool                    above_start = segment->start_inclusive ? (distance >= segment->x_start)
+                                                                                       : (distance > segment->x_start);
+
+                        if (above_start && (distance <= segment->x_end))
+                        {
+                                threshold = (distance * segment->slope) + segment->intercept;
+                                break;
+                        }
+                }
+
+                plan->thresholds[i] = threshold;
+        }
+
+        return true;
+}
+
+uint32_t detection_plan_storage_size(uint16_t capacity)
+{
+        return (uint32_t)capacity * (sizeof(float) + sizeof(uint32_t));
+}
+
+void detection_plan_init(DetectionPlan *plan, void *storage, uint16_t capacity)
+{
+        memset(plan, 0, sizeof(*plan));
+
+        plan->capacity         = (storage != NULL) ? capacity : 0;
+        plan->thresholds       = storage;
+        plan->power_thresholds = (uint32_t *)(plan->thresholds + plan->capacity);
+}
+
+float detection_plan_distance(const DetectionPlan *plan, int32_t index)
+{
+        return (index * plan->bin_step) + plan->origin;
+}
+
+bool detection_plan_build(DetectionPlan *plan, const PrintDataConfig *print_data_config)
+{
+        make_key(&plan->key, print_data_config);
+        plan->valid = false;
+
+        if (print_data_config->num_points > plan->capacity)
+        {
+                return false;
+        }
+
+        // Float form of the detector's per-sample expression
+        // (i * rf_factor_step * step) + (start_point * rf_factor_step)
+        double rf_factor_step = 0.0025 / print_data_config->rf_factor; // meters
+
+        plan->num_points = print_data_config->num_points;
+        plan->stride     = print_data_config->num_points;
+        plan->origin     = (float)(print_data_config->start_point * rf_factor_step);
+        plan->bin_step   = (float)(rf_factor_step * print_data_config->step);
+
+        // The three configured lines, in the order of the original if/else chain
+        const float      *x = print_data_config->x_intercepts;
+        DetectionSegment segments[3] = {
+                { x[0], x[1], print_data_config->line1_slope, print_data_config->y_inter_line1, true },
+                { x[1], x[2], print_data_config->line2_slope, print_data_config->y_inter_line2, false },
+                { x[2], x[3], print_data_config->line3_slope, print_data_config->y_inter_line3, false },
+        };
+
+        plan->valid = detection_plan_set_segments(plan, segments, 3);
+        return plan->valid;
+}
+
+bool detection_plan_build_delay_n_compare(DetectionPlan *plan, const PrintDataConfig *print_data_config)
+{
+        make_key(&plan->key, print_data_config);
+        plan->valid = false;
+
+        if (print_data_config->num_points > plan->capacity)
+        {
+                return false;
+        }
+
+        plan->num_points = print_data_config->num_points;
+        plan->stride     = print_data_config->num_points;
+        plan->origin     = print_data_config->start * 0.0025f;
+        plan->bin_step   = 0.0025f;
+
+        // A distance on x_intercepts[1] matches the first line, as in the original chain
+        const float      *x = print_data_config->x_intercepts;
+        DetectionSegment segments[2] = {
+                { x[0], x[1], print_data_config->line1_slope, print_data_config->y_inter_line1, true },
+                { x[1], x[2], print_data_config->line2_slope, print_data_config->y_inter_line2, true },
+        };
+
+        plan->valid = detection_plan_set_segments(plan, segments, 2);
+        return plan->valid;
+}
+
+bool detection_plan_is_stale(const DetectionPlan *plan, const PrintDataConfig *print_data_config)
+{
+        DetectionPlanKey key;
+
+        make_key(&key, print_data_config);
+        return memcmp(&key, &plan->key, sizeof(key)) != 0;
+}
+
+// Smallest amplitude A for which ((float)A - threshold) > 0, the compare the
+// detectors use; saturates to UINT64_MAX when no amplitude passes
+static uint64_t min_amplitude_above(float threshold)
+{
+        if (threshold < 0.0f)
+        {
+                return 0;
+        }
+        if (!(threshold < 4294967296.0f)) // Also catches NaN
+        {
+                return UINT64_MAX;
+        }
+
+        // Above 2^24 (float)A rounds, so step past values that round down onto threshold
+        uint64_t amplitude = (uint64_t)threshold + 1U;
+        while (!((float)amplitude > threshold))
+        {
+                amplitude++;
+        }
+
+        return amplitude;
+}
+
+void detection_plan_set_divisor(DetectionPlan *plan, uint16_t divisor, uint16_t sweeps)
+{
+        divisor = (divisor == 0) ? 1 : divisor;
+        sweeps  = (sweeps == 0) ? 1 : sweeps;
+        if (plan->divisor == divisor && plan->sweeps == sweeps)
+        {
+                return;
+        }
+
+        // sum / sweeps / divisor >= A  <=>  sum >= A * sweeps * divisor (integer
+        // division rounds down, and floor(floor(s / a) / b) == floor(s / (a * b)))
+        uint32_t scale = (uint32_t)divisor * sweeps;
+
+        for (uint16_t i = 0; i < plan->num_points; i++)
+        {
+                uint64_t amplitude = min_amplitude_above(plan->thresholds[i]);
+                uint64_t limit     = (amplitude > UINT32_MAX / scale) ? UINT32_MAX : amplitude * scale;
+
+                plan->power_thresholds[i] = (uint32_t)limit;
+        }
+
+        plan->divisor = divisor;
+        plan->sweeps  = sweeps;
+}
+
+DetectionCrossing detection_plan_find_crossing(const DetectionPlan *plan, const acc_int16_complex_t *data, uint16_t sweeps)
+{
+        return detection_plan_find_crossing_in(plan, data, sweeps, 0, plan->num_points);
+}
+
+DetectionCrossing detection_plan_find_crossing_in(const DetectionPlan *plan, const acc_int16_complex_t *data, uint16_t sweeps,
+                                                  uint16_t first_bin, uint16_t end_bin)
+{
+        const uint32_t    *limits   = plan->power_thresholds;
+        DetectionCrossing crossing = { -1, 0 };
+        uint32_t          power[DETECTION_PLAN_BLOCK];
+
+        end_bin = (end_bin > plan->num_points) ? plan->num_points : end_bin;
+
+        // Blocks keep the early exit while the power kernel stays vectorized
+        for (uint16_t block = first_bin; block < end_bin; block += DETECTION_PLAN_BLOCK)
+        {
+                uint16_t count = end_bin - block;
+                count = (count > DETECTION_PLAN_BLOCK) ? DETECTION_PLAN_BLOCK : count;
+
+                power_kernel_integrate(&data[block], plan->stride, sweeps, power, count);
+
+                for (uint16_t j = 0; j < count; j++)
+                {
+                        crossing.max_power = (power[j] > crossing.max_power) ? power[j] : crossing.max_power;
+                        if (power[j] >= limits[block + j])
+                        {
+                                crossing.index = block + j;
+                                return crossing;
+                        }
+                }
+        }
+
+        return crossing;
+}
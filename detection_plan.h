@@ -0,0 +1,119 @@
+// Detection Plan
+// Per-bin threshold arrays for the threshold detectors, built once per
+// configuration so the per-frame loop is a straight compare over contiguous
+// arrays instead of walking the x_intercepts chain for every sample. Bin
+// distances are not stored: they follow from the first bin and the bin step,
+// see detection_plan_distance().
+//
+// The arrays live in storage the caller attaches with detection_plan_init(),
+// sized for the points the plan will be built with (8 bytes per bin).
+//
+// Thresholds are also kept pre-scaled by the temperature divisor and the sweep
+// count as limits on the raw power (re^2 + im^2) summed over the sweeps, so the
+// kernel compares power without dividing per bin.
+
+#ifndef DETECTION_PLAN_H
+#define DETECTION_PLAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_definitions_common.h"
+#include "print_data_config.h"
+
+#define DETECTION_PLAN_MAX_SEGMENTS (8U)
+
+// One threshold line: threshold = distance * slope + intercept for distances in
+// (x_start, x_end], or [x_start, x_end] when start_inclusive is set
+typedef struct
+{
+        float x_start;
+        float x_end;
+        float slope;
+        float intercept;
+        bool  start_inclusive;
+} DetectionSegment;
+
+// Config fields the plan depends on, compared to detect a config change
+typedef struct
+{
+        float    rf_factor;
+        uint16_t step;
+        int32_t  start_point;
+        int32_t  start;
+        uint16_t num_points;
+        float    x_intercepts[4];
+        float    slopes[3];
+        float    intercepts[3];
+} DetectionPlanKey;
+
+typedef struct
+{
+        bool             valid;
+        uint16_t         num_points;
+        uint16_t         capacity;          // Bins the attached storage holds
+        float            origin;            // Distance of bin 0 (m)
+        float            bin_step;          // Distance from one bin to the next (m)
+        float            *thresholds;       // Amplitude threshold, 0 outside every segment
+        uint32_t         *power_thresholds; // Summed power limit at divisor and sweeps
+        uint16_t         divisor;           // Divisor of power_thresholds[], 0 = not scaled yet
+        uint16_t         sweeps;            // Sweeps summed in power_thresholds[]
+        uint16_t         stride;            // Samples from one sweep to the next in a frame
+        uint16_t         segment_count;
+        DetectionSegment segments[DETECTION_PLAN_MAX_SEGMENTS];
+        DetectionPlanKey key;
+} DetectionPlan;
+
+// First threshold crossing found by detection_plan_find_crossing()
+typedef struct
+{
+        int32_t  index;    // First bin with power at or above its limit, -1 if none
+        uint32_t max_power; // Highest summed power in bins 0..index (all bins if none crossed)
+} DetectionCrossing;
+
+// Bytes of storage a plan of up to capacity bins needs
+uint32_t detection_plan_storage_size(uint16_t capacity);
+
+// Attach storage of detection_plan_storage_size(capacity) bytes, 4-byte aligned,
+// and mark the plan invalid until it is built
+void detection_plan_init(DetectionPlan *plan, void *storage, uint16_t capacity);
+
+// Build the plan from the sweep and three-line threshold settings in the config.
+// Returns false (plan invalid) if num_points exceeds the plan's capacity.
+bool detection_plan_build(DetectionPlan *plan, const PrintDataConfig *print_data_config);
+
+// Same for the delay-and-compare detector: its distances ignore rf_factor and step
+// and it uses the first two lines only
+bool detection_plan_build_delay_n_compare(DetectionPlan *plan, const PrintDataConfig *print_data_config);
+
+// Replace the threshold segments and recompute the threshold array. The first
+// segment containing a bin's distance sets its threshold.
+bool detection_plan_set_segments(DetectionPlan *plan, const DetectionSegment *segments, uint16_t segment_count);
+
+// Distance of a bin (m); also valid for bins past num_points
+float detection_plan_distance(const DetectionPlan *plan, int32_t index);
+
+// True if the plan was not built from the current config
+bool detection_plan_is_stale(const DetectionPlan *plan, const PrintDataConfig *print_data_config);
+
+// Rescale power_thresholds[] for a new temperature divisor or sweep count; no-op
+// if unchanged. For power summed over sweeps (power_kernel_integrate()),
+// power >= power_thresholds[i] exactly when the float compare
+// ((float)(power / sweeps / divisor) - thresholds[i]) > 0 holds.
+void detection_plan_set_divisor(DetectionPlan *plan, uint16_t divisor, uint16_t sweeps);
+
+// One pass over the first plan->num_points bins, integrated over sweeps (see
+// power_kernel_integrate()): tracks the max power and stops at the first bin
+// whose power reaches its limit. No division. Call detection_plan_set_divisor()
+// with the same sweeps first.
+// Sweeps are plan->stride samples apart; a build sets it to num_points, so for
+// a frame with several subsweeps set it to the sweep length and pass data at
+// the subsweep offset.
+DetectionCrossing detection_plan_find_crossing(const DetectionPlan *plan, const acc_int16_complex_t *data, uint16_t sweeps);
+
+// Same, over bins first_bin..end_bin-1 only (clamped to the plan); max_power
+// then covers only those bins
+DetectionCrossing detection_plan_find_crossing_in(const DetectionPlan *plan, const acc_int16_complex_t *data, uint16_t sweeps,
+                                                  uint16_t first_bin, uint16_t end_bin);
+
+#endif // DETECTION_PLAN_H
@@ -0,0 +1,86 @@
+// Detector Interface
+// A detector turns one processed frame into a distance. acc_service() looks the
+// detector for PrintDataConfig::algo up once in its registry and then makes a
+// single indirect call per frame, so a new detector is a new registry entry
+// and never touches the measurement loop.
+//
+// State is owned by the caller and handed to every call. It is a union sized
+// for the largest detector, so only one detector's state is live at a time.
+// Per-bin arrays, whose size depends on the config, are allocated once by the
+// caller at the size storage_size() asks for and handed to init().
+
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_config.h"
+#include "acc_definitions_common.h"
+#include "acc_processing.h"
+#include "detection_plan.h"
+#include "print_data_config.h"
+#include "processed_data.h"
+#include "tracking_gate.h"
+
+// One frame as handed to a detector
+typedef struct
+{
+        const acc_int16_complex_t       *data;
+        uint16_t                        data_length; // num_points * sweeps_per_frame
+        uint16_t                        temp;        // Sensor temperature (degrees C)
+        const acc_processing_metadata_t *proc_meta;  // Subsweep layout of data
+} DetectorFrame;
+
+typedef union
+{
+        DetectionPlan plan; // Threshold, delay-and-compare and CA-CFAR detectors
+
+        struct
+        {
+                DetectionPlan plan;
+                TrackingGate  gate;
+        } tracked; // Threshold detector with a tracking gate
+
+        struct
+        {
+                DetectionPlan coarse;
+                DetectionPlan fine;
+                bool          configured;   // Subsweeps programmed into the sensor config
+                int32_t       fine_start;   // Start point of the fine subsweep
+                bool          target_valid; // Coarse crossing found in the last frame
+                int32_t       target_point; // Its sweep point
+        } coarse_fine; // Threshold detector over coarse and fine subsweeps
+} DetectorState;
+
+typedef struct
+{
+        int        algo; // PrintDataConfig::algo value selecting this detector
+        const char *name;
+
+        // Bytes of storage init() needs for this config; may be NULL
+        uint32_t (*storage_size)(const PrintDataConfig *print_data_config);
+
+        // Called once the sensor is configured, with storage_size() bytes of
+        // storage (NULL if none) that stay valid until the detector is done
+        void (*init)(DetectorState *state, void *storage, const PrintDataConfig *print_data_config);
+
+        // Distance in 0.1 mm (the 0x13 CAN unit), 0 when nothing was detected.
+        // Fills proc_data on a detection.
+        uint32_t (*process_frame)(DetectorState *state, const DetectorFrame *frame,
+                                  const PrintDataConfig *print_data_config, ProcessedData *proc_data);
+
+        // Called after a re-calibration to drop history from earlier frames; may be NULL
+        void (*reset)(DetectorState *state);
+
+        // Sweep point of the target while the detector holds a lock on it, for the
+        // adaptive sweep window; NULL for detectors that do not track
+        bool (*target_point)(const DetectorState *state, int32_t *point);
+
+        // Adjusts the sensor config set_config() built: called once before the
+        // sensor is prepared and after every frame. Returns true when it changed
+        // the config and the sensor must be prepared again; may be NULL.
+        bool (*update_config)(DetectorState *state, acc_config_t *config, const PrintDataConfig *print_data_config);
+} Detector;
+
+#endif // DETECTOR_H
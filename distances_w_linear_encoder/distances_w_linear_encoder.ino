@@ -100,6 +100,9 @@ void setup() {
   digitalWrite(PIN_CAN_BOOSTEN, true); // turn on booster
 
   // start the CAN bus at 250 kbps
+  // CANSAME5x is classic CAN only: the sensor must not be built with
+  // CAN_FD_TELEMETRY or CAN_FD_BURST on a bus this bridge is on (its FD frames
+  // would show up here as bus errors), so cases 0x15 and 0x16 below never run
   if (!CAN.begin(500000)) {
     Serial.println("Starting CAN failed!");
     // while (1) delay(10);
@@ -142,7 +145,79 @@ void u32ToBytes(unsigned long v, uint8_t* out) {
   out[3] = v & 0xFF;
 }
 
+// Helper: sample the position sensor and pack the 14-byte type 0x10 layout:
+// distance (4), temp (2), positionValue (4), distanceOutput (4)
+void packDistanceTelemetry(unsigned long distance, unsigned long temp, uint8_t* payload) {
+  // Get position based on selected sensor type
+  long positionValue;
+  long distanceOutput;
+  if (POSITION_SENSOR_TYPE == 0) {
+    // Linear encoder - use encoder position (counts)
+    positionValue = encoderPos;
+    distanceOutput = 0; // No distance output for linear encoder mode
+  } else {
+    // String potentiometer - convert mm to counts (*100 for two decimal places)
+    float stringPotPos = readStringPotPosition();
+    distanceOutput = (long)(readDistanceOutput() * 100.0); // Convert to int with 2 decimal places
+    positionValue = (long)(stringPotPos * 100.0); // Convert to int with 2 decimal places
+  }
+
+  u32ToBytes(distance, payload);
+  payload[4] = (temp >> 8) & 0xFF;
+  payload[5] = temp & 0xFF;
+  // positionValue as 32-bit (signed)
+  payload[6] = (positionValue >> 24) & 0xFF;
+  payload[7] = (positionValue >> 16) & 0xFF;
+  payload[8] = (positionValue >> 8) & 0xFF;
+  payload[9] = positionValue & 0xFF;
+  // distanceOutput as 32-bit (signed)
+  payload[10] = (distanceOutput >> 24) & 0xFF;
+  payload[11] = (distanceOutput >> 16) & 0xFF;
+  payload[12] = (distanceOutput >> 8) & 0xFF;
+  payload[13] = distanceOutput & 0xFF;
+}
+
+// Host -> bridge frames use the same framing. Type 0xC1 = transmit CAN frame:
+// id(2) | data(8), used by the host tools for lookup table downloads (0x610-0x612)
+uint8_t rxFrame[3 + 255];  // type, len, payload, chk
+int rxIndex = -1;  // -1 = waiting for 0x7E
+uint8_t rxLen = 0;
+
+void handleHostFrame(uint8_t type, const uint8_t* payload, uint8_t len) {
+  if (type == 0xC1 && len == 10) {
+    uint16_t id = ((uint16_t)payload[0] << 8) | payload[1];
+    CAN.beginPacket(id);
+    CAN.write(payload + 2, 8);
+    CAN.endPacket();
+  }
+}
+
+// Parse host frames byte by byte so CAN reception is never blocked
+void pollHostSerial() {
+  while (Serial.available()) {
+    uint8_t b = Serial.read();
+    if (rxIndex < 0) {
+      if (b == 0x7E) rxIndex = 0;
+      continue;
+    }
+
+    rxFrame[rxIndex++] = b;
+    if (rxIndex == 2) rxLen = b;
+    if (rxIndex < 2 || rxIndex < 2 + rxLen + 1) continue;
+
+    // rxFrame = type, len, payload..., chk
+    uint8_t chk = 0;
+    for (int i = 0; i < 2 + rxLen; i++) chk ^= rxFrame[i];
+    if (chk == rxFrame[2 + rxLen]) {
+      handleHostFrame(rxFrame[0], rxFrame + 2, rxLen);
+    }
+    rxIndex = -1;
+  }
+}
+
 void loop() {
+  pollHostSerial();
+
   // TESTING FOR THE STRING POT
   // long positionValue;
   // if (POSITION_SENSOR_TYPE == 0) {
@@ -174,13 +249,14 @@ void loop() {
     // Packet received (binary framing used for output)
     uint32_t packetId = CAN.packetId();
     
-    int data[8];
+    // Up to 64 bytes for CAN FD frames
+    int data[64];
     int index = 0;
     while (CAN.available()) {
-      if (index < 8) {
+      if (index < 64) {
         data[index++] = CAN.read();
       } else {
-        CAN.read(); // discard if more than 8 bytes
+        CAN.read(); // discard if more than 64 bytes
       }
     }
 
@@ -198,41 +274,76 @@ void loop() {
           unsigned long temp = ((unsigned long)data[6] << 8) |
                                 (unsigned long)data[7];
 
-          // Get position based on selected sensor type
-          long positionValue;
-          long distanceOutput;
-          if (POSITION_SENSOR_TYPE == 0) {
-            // Linear encoder - use encoder position (counts)
-            positionValue = encoderPos;
-            distanceOutput = 0; // No distance output for linear encoder mode
-          } else {
-            // String potentiometer - convert mm to counts (*100 for two decimal places)
-            float stringPotPos = readStringPotPosition();
-            distanceOutput = (long)(readDistanceOutput() * 100.0); // Convert to int with 2 decimal places
-            positionValue = (long)(stringPotPos * 100.0); // Convert to int with 2 decimal places
-          }
-
           // Pack: distance (4), temp (2), positionValue (4), distanceOutput (4)
           uint8_t payload[14];
-          u32ToBytes(distance, payload);
-          payload[4] = (temp >> 8) & 0xFF;
-          payload[5] = temp & 0xFF;
-          // positionValue as 32-bit (signed)
-          payload[6] = (positionValue >> 24) & 0xFF;
-          payload[7] = (positionValue >> 16) & 0xFF;
-          payload[8] = (positionValue >> 8) & 0xFF;
-          payload[9] = positionValue & 0xFF;
-          // distanceOutput as 32-bit (signed)
-          payload[10] = (distanceOutput >> 24) & 0xFF;
-          payload[11] = (distanceOutput >> 16) & 0xFF;
-          payload[12] = (distanceOutput >> 8) & 0xFF;
-          payload[13] = distanceOutput & 0xFF;
+          packDistanceTelemetry(distance, temp, payload);
           
           // type 0x10 = telemetry distance
           sendFrame(0x10, payload, 14);
           break;
         }
         
+        // CAN FD telemetry: everything 0x13 and 0x14 carry, plus sequence and timestamp.
+        // Untested: only reachable with a CAN FD capable controller, see CAN.begin()
+        case 0x15: {
+          if (index < 32) break;
+
+          unsigned long distance = ((unsigned long)data[0] << 24) |
+                                    ((unsigned long)data[1] << 16) |
+                                    ((unsigned long)data[2] << 8) |
+                                    (unsigned long)data[3];
+          unsigned long temp = ((unsigned long)data[6] << 8) |
+                                (unsigned long)data[7];
+
+          // Pack: same 14 bytes as type 0x10, then the 32-byte CAN FD payload as received
+          uint8_t payloadF[14 + 32];
+          packDistanceTelemetry(distance, temp, payloadF);
+          for (int i = 0; i < 32; i++) payloadF[14 + i] = data[i] & 0xFF;
+          // type 0x12 = CAN FD telemetry
+          sendFrame(0x12, payloadF, 14 + 32);
+          break;
+        }
+        
+        // CAN FD burst: up to 9 samples of distance(3), temp(1), tick delta(2)
+        // after base tick(4), burst sequence(2), count(1), reserved(1).
+        // Untested: only reachable with a CAN FD capable controller, see CAN.begin()
+        case 0x16: {
+          if (index < 64) break;
+
+          unsigned long baseTick = ((unsigned long)data[0] << 24) |
+                                    ((unsigned long)data[1] << 16) |
+                                    ((unsigned long)data[2] << 8) |
+                                    (unsigned long)data[3];
+          int count = min(data[6], 9);
+
+          // The position is sampled once per burst, so every sample of it
+          // shares the reading taken when the burst arrived
+          uint8_t payloadB[14 + 8];
+          packDistanceTelemetry(0, 0, payloadB);
+
+          for (int s = 0; s < count; s++) {
+            const int* sample = &data[8 + s * 6];
+            unsigned long distance = ((unsigned long)sample[0] << 16) |
+                                      ((unsigned long)sample[1] << 8) |
+                                      (unsigned long)sample[2];
+            long temp = (int8_t)sample[3];
+            unsigned long tick = baseTick + (((unsigned long)sample[4] << 8) | (unsigned long)sample[5]);
+
+            // Pack: type 0x10 layout, then tick(4), burst sequence(2), sample index(1), count(1)
+            u32ToBytes(distance, payloadB);
+            payloadB[4] = (temp >> 8) & 0xFF;
+            payloadB[5] = temp & 0xFF;
+            u32ToBytes(tick, payloadB + 14);
+            payloadB[18] = data[4] & 0xFF;
+            payloadB[19] = data[5] & 0xFF;
+            payloadB[20] = s;
+            payloadB[21] = count;
+            // type 0x13 = one sample of a CAN FD burst
+            sendFrame(0x13, payloadB, 14 + 8);
+          }
+          break;
+        }
+        
         // Amplitude telemetry data
         case 0x14: {
           unsigned long max_amplitude = ((unsigned long)data[0] << 24) |
@@ -328,6 +439,56 @@ void loop() {
           break;
         }
         
+        // Tracking gate statistics
+        case 0x604: {
+          // Pack: hits(2), misses(2), full_scans(2), bins_per_frame(2) as received
+          uint8_t payloadG[8];
+          for (int i = 0; i < 8; i++) payloadG[i] = data[i] & 0xFF;
+          // type 0xA4 = tracking gate stats
+          sendFrame(0xA4, payloadG, 8);
+          break;
+        }
+        
+        // CAN TX queue statistics
+        case 0x605: {
+          // Pack: queued(2), overflows(2), hal_errors(2), high_water(1), size(1) as received
+          uint8_t payloadQ[8];
+          for (int i = 0; i < 8; i++) payloadQ[i] = data[i] & 0xFF;
+          // type 0xA5 = CAN TX queue stats
+          sendFrame(0xA5, payloadQ, 8);
+          break;
+        }
+        
+        // Deferred log message
+        case 0x620: {
+          // Pack: id(1), dropped(1), tick(2), arg(4) as received
+          uint8_t payloadD[8];
+          for (int i = 0; i < 8; i++) payloadD[i] = data[i] & 0xFF;
+          // type 0xA6 = deferred log message, see deferred_log.py
+          sendFrame(0xA6, payloadD, 8);
+          break;
+        }
+        
+        // Lookup table download status
+        case 0x613: {
+          // Pack: state(1), error(1), active_size(2), active_crc(4) as received
+          uint8_t payloadL[8];
+          for (int i = 0; i < 8; i++) payloadL[i] = data[i] & 0xFF;
+          // type 0xC0 = lookup table download status
+          sendFrame(0xC0, payloadL, 8);
+          break;
+        }
+        
+        // Lookup table download progress
+        case 0x614: {
+          // Pack: next_word(2), total_words(2), reserved(4) as received
+          uint8_t payloadP[8];
+          for (int i = 0; i < 8; i++) payloadP[i] = data[i] & 0xFF;
+          // type 0xC2 = lookup table download progress
+          sendFrame(0xC2, payloadP, 8);
+          break;
+        }
+        
         // Performance Timing Data
         case 0x700: {
           unsigned int timer_id = data[0];
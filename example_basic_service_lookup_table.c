@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "acc_config.h"
 #include "acc_definitions_a121.h"
@@ -30,7 +31,21 @@
 
 // Include generated lookup tables from sensor comparison tool
 #include "lookup_table.h"          // Position-distance lookup table
+#ifndef LOOKUP_TABLE_FUSED                 // A fused lookup table already contains the error correction
 #include "error_correction_table.h" // Error correction lookup table
+#endif
+#include "lut_download.h"           // Lookup table downloaded over CAN at runtime
+#include "detection_plan.h"
+#include "detector.h"
+#include "cfar.h"
+#include "tracking_gate.h"
+#include "sweep_window.h"
+#include "coarse_fine.h"
+#include "measure_pipeline.h"
+#include "can_tx_queue.h"
+#include "telemetry_burst.h"
+#include "power_kernel.h"
+#include "deferred_log.h"
 
 
 /** \example example_service.c
@@ -53,17 +68,97 @@
 #define SENSOR_TIMEOUT_MS  (1000U)
 #define MAX_DATA_ENTRY_LEN (15U) // "-32000+-32000i" + zero termination
 
+#ifdef CAN_FD_TELEMETRY
+// One CAN FD frame per result instead of 0x14 and 0x13 (big-endian):
+//   0x15 TELEMETRY  sensor -> host  distance (u32, 0.1 mm, averaged as on 0x13),
+//                                   divisor (u16), temp (u16), max amplitude (u32),
+//                                   first threshold y (u32), detector distance
+//                                   (u32, 0.1 mm, before averaging), first
+//                                   threshold x (u32, 0.1 mm), frame sequence
+//                                   (u32), timestamp (u32, ms)
+// Every node on the bus must be CAN FD capable.
+#define CAN_FD_TELEMETRY_ID     (0x15U)
+#define CAN_FD_TELEMETRY_LENGTH (32U)
+#endif
+
+#if defined(CAN_FD_TELEMETRY) || defined(CAN_FD_BURST)
+// The distances_w_linear_encoder bridge runs CANSAME5x, which is classic CAN
+// only: it never receives 0x15 / 0x16 and flags every CAN FD frame on the bus
+// as an error, and its unpacking of them is untested. Define CAN_FD_BRIDGE
+// only once the bus has a CAN FD capable receiver at matching nominal and data
+// bit rates.
+#ifndef CAN_FD_BRIDGE
+#error "CAN_FD_TELEMETRY and CAN_FD_BURST need a CAN FD capable bridge, see CAN_FD_BRIDGE"
+#endif
+#endif
+
 extern FDCAN_HandleTypeDef hfdcan1;
 
+// State of the configured detector, see detector.h
+static DetectorState detector_state;
+
+// Per-bin arrays of the configured detector, see Detector::storage_size
+static void *detector_storage = NULL;
+
 static void set_config(acc_config_t *config, PrintDataConfig *print_data_config);
 
 
-static bool do_sensor_calibration_and_prepare(acc_sensor_t *sensor, acc_config_t *config, void *buffer, uint32_t buffer_size);
+static bool do_sensor_calibration_and_prepare(acc_sensor_t *sensor, acc_config_t *config, acc_cal_result_t *cal_result, void *buffer, uint32_t buffer_size);
+
+// Apply a changed config from the next frame on, keeping the calibration
+static bool reprepare_sensor(acc_sensor_t *sensor, acc_config_t *config, acc_processing_t **processing,
+                             acc_processing_metadata_t *proc_meta, const acc_cal_result_t *cal_result,
+                             MeasurePipeline *pipeline, void *buffer, uint32_t buffer_size);
+
+
+// Plan storage for the detectors with one plan over the configured sweep
+static uint32_t single_plan_storage_size(const PrintDataConfig *print_data_config);
+
+static void simple_threshold_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config);
+
+uint32_t run_simple_threshold_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data);
+
+static void tracked_threshold_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config);
+
+uint32_t run_tracked_threshold_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data);
 
+static void tracked_threshold_reset(DetectorState *state);
 
-uint32_t run_simple_threshold_algo(acc_int16_complex_t *data, uint16_t data_length, PrintDataConfig *print_data_config, uint16_t temp, ProcessedData *proc_data);
+static bool tracked_threshold_target_point(const DetectorState *state, int32_t *point);
 
-uint32_t run_delay_n_compare_algo(acc_int16_complex_t *data, uint16_t data_length, PrintDataConfig *print_data_config, uint16_t temp);
+static uint32_t coarse_fine_storage_size(const PrintDataConfig *print_data_config);
+
+static void coarse_fine_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config);
+
+uint32_t run_coarse_fine_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data);
+
+static bool coarse_fine_update_config(DetectorState *state, acc_config_t *config, const PrintDataConfig *print_data_config);
+
+// Simple threshold detection, searching only the tracking gate when gate is not NULL
+static uint32_t threshold_detect(DetectionPlan *plan, TrackingGate *gate, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data);
+
+// Sub-bin distance (m) of the threshold crossing between bins index - 1 and index
+static float interpolate_crossing(const DetectionPlan *plan, const acc_int16_complex_t *data, uint16_t sweeps_per_frame, int index, uint16_t divisor, uint32_t max_power, ProcessedData *proc_data);
+
+static void delay_n_compare_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config);
+
+uint32_t run_delay_n_compare_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data);
+
+uint32_t run_cfar_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data);
+
+// Detectors selectable with PrintDataConfig::algo
+static const Detector detectors[] = {
+        { 1, "simple threshold", single_plan_storage_size, simple_threshold_init, run_simple_threshold_algo, NULL, NULL, NULL },
+        { 2, "delay and compare", single_plan_storage_size, delay_n_compare_init, run_delay_n_compare_algo, NULL, NULL, NULL },
+        { 3, "CA-CFAR", single_plan_storage_size, simple_threshold_init, run_cfar_algo, NULL, NULL, NULL },
+        { 4, "simple threshold, tracked", single_plan_storage_size, tracked_threshold_init, run_tracked_threshold_algo, tracked_threshold_reset, tracked_threshold_target_point, NULL },
+        { 5, "coarse to fine", coarse_fine_storage_size, coarse_fine_init, run_coarse_fine_algo, NULL, NULL, coarse_fine_update_config },
+};
+
+static const Detector *find_detector(int algo);
+
+// Amplitude divisor compensating the temperature dependence of the return
+static uint16_t temperature_divisor(uint16_t temp);
 
 static void cleanup(acc_config_t *config, acc_processing_t *processing,
                     acc_sensor_t *sensor, void *buffer);
@@ -72,7 +167,21 @@ static void cleanup(acc_config_t *config, acc_processing_t *processing,
 static bool lookup_tables_available(void);
 
 // Enhanced distance correction using generated lookup tables
-static float apply_distance_correction(float raw_distance_mm);
+static float apply_distance_correction(float raw_distance_mm, float temperature_c);
+
+// Corrected detector distance in 0.1 mm units, the unit sent on 0x13
+static uint32_t correct_selected_distance(float selected_m, uint16_t temp);
+
+#ifdef LOOKUP_TABLE_FIXED_POINT
+// Distance correction in 0.1 mm integer units using a fixed-point lookup table
+static uint32_t apply_distance_correction_q(uint32_t raw_distance_q, float temperature_c);
+#endif
+
+#ifdef CAN_FD_TELEMETRY
+// Queue the 0x15 telemetry frame for one result
+static bool send_fd_telemetry(uint32_t sequence, uint32_t avg_distance, uint32_t distance, uint16_t temp,
+                              const ProcessedData *proc_data);
+#endif
 
 int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config);
 
@@ -88,8 +197,22 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
         uint32_t                  buffer_size = 0;
         acc_processing_metadata_t proc_meta;
         acc_processing_result_t   proc_result;
+        acc_cal_result_t          cal_result;
+        MeasurePipeline           pipeline;
+        const PrintDataConfig     *sweep_config = print_data_config; // Range actually swept
+#ifdef ADAPTIVE_SWEEP_WINDOW
+        PrintDataConfig           window_config;
+        SweepWindow               sweep_window;
+        sweep_window_full(print_data_config, &sweep_window);
+#endif
         uint32_t timestamp = 0;
         uint32_t timestamp_delta = 0;
+#if defined(CAN_FD_BURST)
+        TelemetryBurst telemetry_burst;
+        telemetry_burst_reset(&telemetry_burst);
+#elif defined(CAN_FD_TELEMETRY)
+        uint32_t telemetry_sequence = 0;
+#endif
         int first_success = 0;
         int second_success = 1;
 
@@ -105,6 +228,8 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
                 return EXIT_FAILURE;
         }
 
+        can_tx_queue_init();
+
         config = acc_config_create();
         if (config == NULL)
         {
@@ -115,6 +240,30 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
 
         set_config(config, print_data_config);
 
+        const Detector *detector = find_detector(print_data_config->algo);
+        if (detector == NULL)
+        {
+                printf("Unknown detector algo %d\n", print_data_config->algo);
+                cleanup(config, processing, sensor, buffer);
+                return EXIT_FAILURE;
+        }
+        uint32_t storage_size = (detector->storage_size != NULL) ? detector->storage_size(print_data_config) : 0;
+        if (storage_size > 0)
+        {
+                detector_storage = acc_integration_mem_alloc(storage_size);
+                if (detector_storage == NULL)
+                {
+                        printf("detector storage allocation failed\n");
+                        cleanup(config, processing, sensor, buffer);
+                        return EXIT_FAILURE;
+                }
+        }
+        detector->init(&detector_state, detector_storage, print_data_config);
+        if (detector->update_config != NULL)
+        {
+                detector->update_config(&detector_state, config, print_data_config);
+        }
+
         // Print the configuration
 //        acc_config_log(config);
 
@@ -133,7 +282,8 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
                 return EXIT_FAILURE;
         }
 
-        buffer = acc_integration_mem_alloc(buffer_size);
+        // Room for a second frame when measurements are pipelined
+        buffer = acc_integration_mem_alloc(measure_pipeline_alloc_size(buffer_size));
         if (buffer == NULL)
         {
                 printf("buffer allocation failed\n");
@@ -152,7 +302,7 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
                 return EXIT_FAILURE;
         }
 
-        if (!do_sensor_calibration_and_prepare(sensor, config, buffer, buffer_size))
+        if (!do_sensor_calibration_and_prepare(sensor, config, &cal_result, buffer, buffer_size))
         {
                 printf("do_sensor_calibration_and_prepare() failed\n");
                 acc_sensor_status(sensor);
@@ -160,6 +310,8 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
                 return EXIT_FAILURE;
         }
 
+        measure_pipeline_init(&pipeline, sensor, SENSOR_ID, SENSOR_TIMEOUT_MS, buffer, buffer_size);
+
         // Check if lookup tables are available
         if (lookup_tables_available()) {
             printf("Lookup tables loaded successfully for distance correction\n");
@@ -179,35 +331,26 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
         };
 
         while (1) {
+    		// Swap in a lookup table downloaded over CAN, only ever between frames
+    		lut_download_poll();
+    		can_tx_queue_poll();
+    		deferred_log_poll();
+
 //			HAL_GPIO_WritePin(ALARM_LIGHT_GPIO_Port, ALARM_LIGHT_Pin, GPIO_PIN_SET);
 		//	HAL_Delay(1);
 //			HAL_GPIO_WritePin(ALARM_LIGHT_GPIO_Port, ALARM_LIGHT_Pin, GPIO_PIN_RESET);
 
-    		if (!acc_sensor_measure(sensor))
-    		{
-    				printf("acc_sensor_measure failed\n");
-    				acc_sensor_status(sensor);
-    				cleanup(config, processing, sensor, buffer);
-    				return EXIT_FAILURE;
-    		}
-
-    		if (!acc_hal_integration_wait_for_sensor_interrupt(SENSOR_ID, SENSOR_TIMEOUT_MS))
-    		{
-    				printf("Sensor interrupt timeout\n");
-    				acc_sensor_status(sensor);
-    				cleanup(config, processing, sensor, buffer);
-    				return EXIT_FAILURE;
-    		}
-
-    		if (!acc_sensor_read(sensor, buffer, buffer_size))
+    		// Measure, wait for the interrupt and read; when pipelined the next
+    		// measurement is already running while this frame is processed
+    		void *frame_buffer = NULL;
+    		if (!measure_pipeline_next(&pipeline, &frame_buffer))
     		{
-    				printf("acc_sensor_read failed\n");
     				acc_sensor_status(sensor);
     				cleanup(config, processing, sensor, buffer);
     				return EXIT_FAILURE;
     		}
 
-    		acc_processing_execute(processing, buffer, &proc_result);
+    		acc_processing_execute(processing, frame_buffer, &proc_result);
 
 //			HAL_GPIO_WritePin(ALARM_LIGHT_GPIO_Port, ALARM_LIGHT_Pin, GPIO_PIN_SET);
 		//	HAL_Delay(3);
@@ -215,23 +358,81 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
 
     		if (proc_result.calibration_needed)
     		{
-    				printf("The current calibration is not valid for the current temperature.\n");
-    				printf("The sensor needs to be re-calibrated.\n");
+    				DEFERRED_LOG(CALIBRATION_NEEDED, 0);
+
+#if defined(CAN_FD_BURST)
+    				// A burst never mixes results from before and after a recalibration
+    				if (!telemetry_burst_flush(&telemetry_burst))
+    				{
+    						DEFERRED_LOG(CAN_TX_FULL, TELEMETRY_BURST_CAN_ID);
+    				}
+#endif
 
-    				if (!do_sensor_calibration_and_prepare(sensor, config, buffer, buffer_size))
+    				if (!measure_pipeline_idle(&pipeline))
+    				{
+    						acc_sensor_status(sensor);
+    						cleanup(config, processing, sensor, buffer);
+    						return EXIT_FAILURE;
+    				}
+
+    				if (!do_sensor_calibration_and_prepare(sensor, config, &cal_result, buffer, buffer_size))
     				{
     						printf("do_sensor_calibration_and_prepare() failed\n");
     						acc_sensor_status(sensor);
     						cleanup(config, processing, sensor, buffer);
     						return EXIT_FAILURE;
     				}
-    				printf("The sensor was successfully re-calibrated.\n");
+    				DEFERRED_LOG(RECALIBRATED, 0);
+
+    				if (detector->reset != NULL) {
+    					detector->reset(&detector_state);
+    				}
     		}
     		else {
-    			printf("sync\n");
+    			bool reconfigured = false; // The next frame is swept with other settings
+    			DEFERRED_LOG(SYNC, 0);
 //    			HAL_GPIO_TogglePin(ALARM_LIGHT_GPIO_Port, ALARM_LIGHT_Pin);
-    			if (print_data_config->algo == 1) {
-    				distance = run_simple_threshold_algo(proc_result.frame, proc_meta.frame_data_length, print_data_config, proc_result.temperature, &proc_data);
+#ifdef ADAPTIVE_SWEEP_WINDOW
+    			// Current settings, except for the range of the window being swept
+    			window_config = *print_data_config;
+    			window_config.start_point = sweep_window.start_point;
+    			window_config.num_points = sweep_window.num_points;
+    			sweep_config = &window_config;
+#endif
+    			DetectorFrame frame = {
+    				.data = proc_result.frame,
+    				.data_length = proc_meta.frame_data_length,
+    				.temp = proc_result.temperature,
+    				.proc_meta = &proc_meta
+    			};
+    			distance = detector->process_frame(&detector_state, &frame, sweep_config, &proc_data);
+
+#ifdef ADAPTIVE_SWEEP_WINDOW
+    			// Narrow the sweep around a locked target, widen it again on loss
+    			int32_t target_point = 0;
+    			bool locked = (detector->target_point != NULL) && detector->target_point(&detector_state, &target_point);
+    			SweepWindow next_window;
+    			if (sweep_window_next(print_data_config, &sweep_window, locked, target_point, &next_window)) {
+    				acc_config_start_point_set(config, next_window.start_point);
+    				acc_config_num_points_set(config, next_window.num_points);
+    				if (!reprepare_sensor(sensor, config, &processing, &proc_meta, &cal_result, &pipeline, buffer, buffer_size)) {
+    					acc_sensor_status(sensor);
+    					cleanup(config, processing, sensor, buffer);
+    					return EXIT_FAILURE;
+    				}
+    				sweep_window = next_window;
+    				reconfigured = true;
+    			}
+#endif
+
+    			// Let the detector move its subsweeps for the next frame
+    			if (detector->update_config != NULL && detector->update_config(&detector_state, config, sweep_config)) {
+    				if (!reprepare_sensor(sensor, config, &processing, &proc_meta, &cal_result, &pipeline, buffer, buffer_size)) {
+    					acc_sensor_status(sensor);
+    					cleanup(config, processing, sensor, buffer);
+    					return EXIT_FAILURE;
+    				}
+    				reconfigured = true;
     			}
     			uint16_t temp = proc_result.temperature;
 
@@ -260,6 +461,35 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
     			uint32_t first_threshold_x = (uint16_t)proc_data.first_threshold_x * 10000;
     			uint16_t divisor = (uint16_t)proc_data.divisor;
 
+#if defined(CAN_FD_BURST)
+    			(void)first_threshold_y;
+    			(void)max_amplitude;
+    			(void)divisor;
+
+    			// Sent every TELEMETRY_BURST_SAMPLES frames, see telemetry_burst.h
+    			first_success = telemetry_burst_add(&telemetry_burst, avg_distance, (int16_t)temp, HAL_GetTick());
+    			// This frame was the last one with the old settings: close its burst early
+    			if (reconfigured) {
+    				first_success = telemetry_burst_flush(&telemetry_burst) && first_success;
+    			}
+    			if (!first_success) {
+    				DEFERRED_LOG(CAN_TX_FULL, TELEMETRY_BURST_CAN_ID);
+    			}
+    			second_success = first_success;
+#elif defined(CAN_FD_TELEMETRY)
+    			(void)first_threshold_y;
+    			(void)max_amplitude;
+    			(void)divisor;
+    			(void)reconfigured;
+
+    			// A gap in the sequence on the host is a dropped frame
+    			first_success = send_fd_telemetry(telemetry_sequence++, avg_distance, (uint32_t)distance, temp, &proc_data);
+    			if (!first_success) {
+    				DEFERRED_LOG(CAN_TX_FULL, CAN_FD_TELEMETRY_ID);
+    			}
+    			second_success = first_success;
+#else
+    			(void)reconfigured;
      			uint8_t data[8];
 
     			data[0] = (max_amplitude >> 24) & 0xFF;
@@ -271,16 +501,14 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
     			data[6] = (first_threshold_y >> 8) & 0xFF;
     			data[7] = first_threshold_y & 0xFF;
 
-    			int ret = MX_FDCAN1_Send(0x14, data);
-    			if (ret == 0) {
-    				printf("still failed after 10 times try");
+    			// Queued, so the loop never waits on the bus
+    			if (!can_tx_queue_send(0x14, data)) {
+    				DEFERRED_LOG(CAN_TX_FULL, 0x14);
     				first_success = 0;
     			} else {
     				first_success = 1;
     			}
 
-    			HAL_Delay(1);
-
 				data[0] = (avg_distance >> 24) & 0xFF;
 				data[1] = (avg_distance >> 16) & 0xFF;
 				data[2] = (avg_distance >> 8) & 0xFF;
@@ -290,14 +518,13 @@ int acc_service(int argc, char *argv[], PrintDataConfig *print_data_config)
 				data[6] = (temp >> 8) & 0xFF;
 				data[7] = temp & 0xFF;
 
-				ret = MX_FDCAN1_Send(0x13, data);
-    			if (ret == 0) {
-    				printf("still failed after 10 times try");
+    			if (!can_tx_queue_send(0x13, data)) {
+    				DEFERRED_LOG(CAN_TX_FULL, 0x13);
     				second_success = 0;
     			} else {
     				second_success = 1;
     			}
-				HAL_Delay(2);
+#endif
 
 				if (first_success && second_success) {
 		   			// calculate the time stamp
@@ -329,15 +556,13 @@ static void set_config(acc_config_t *config, PrintDataConfig *print_data_config)
     acc_config_hwaas_set(config, print_data_config->ave);
     acc_config_phase_enhancement_set(config, true);
 //    acc_config_enable_loopback_set(config, true);
-
 }
 
 
-static bool do_sensor_calibration_and_prepare(acc_sensor_t *sensor, acc_config_t *config, void *buffer, uint32_t buffer_size)
+static bool do_sensor_calibration_and_prepare(acc_sensor_t *sensor, acc_config_t *config, acc_cal_result_t *cal_result, void *buffer, uint32_t buffer_size)
 {
         bool             status       = false;
         bool             cal_complete = false;
-        acc_cal_result_t cal_result;
         const uint16_t   calibration_retries = 1U;
 
         // Random disturbances may cause the calibration to fail. At failure, retry at least once.
@@ -349,7 +574,7 @@ static bool do_sensor_calibration_and_prepare(acc_sensor_t *sensor, acc_config_t
 
                 do
                 {
-                        status = acc_sensor_calibrate(sensor, &cal_complete, &cal_result, buffer, buffer_size);
+                        status = acc_sensor_calibrate(sensor, &cal_complete, cal_result, buffer, buffer_size);
 
                         if (status && !cal_complete)
                         {
@@ -364,95 +589,158 @@ static bool do_sensor_calibration_and_prepare(acc_sensor_t *sensor, acc_config_t
                 acc_hal_integration_sensor_disable(SENSOR_ID);
                 acc_hal_integration_sensor_enable(SENSOR_ID);
 
-                status = acc_sensor_prepare(sensor, config, &cal_result, buffer, buffer_size);
+                status = acc_sensor_prepare(sensor, config, cal_result, buffer, buffer_size);
         }
 
         return status;
 }
 
-uint32_t run_simple_threshold_algo(acc_int16_complex_t *data, uint16_t data_length, PrintDataConfig *print_data_config, uint16_t temp, ProcessedData *proc_data)
+static bool reprepare_sensor(acc_sensor_t *sensor, acc_config_t *config, acc_processing_t **processing,
+                             acc_processing_metadata_t *proc_meta, const acc_cal_result_t *cal_result,
+                             MeasurePipeline *pipeline, void *buffer, uint32_t buffer_size)
 {
-		float rf_factor_step = 0.0025 / print_data_config->rf_factor; // meters
-	    float selected = 0;
+        // A frame already being measured has the old layout
+        if (!measure_pipeline_idle(pipeline))
+        {
+                return false;
+        }
+
+        // The frame layout changes with the points swept
+        acc_processing_destroy(*processing);
+        *processing = acc_processing_create(config, proc_meta);
+        if (*processing == NULL)
+        {
+                printf("acc_processing_create() failed\n");
+                return false;
+        }
+
+        // Callers only shrink or move the swept points, so the buffer sized for the
+        // initial config still fits, and the calibration does not depend on them
+        if (!acc_sensor_prepare(sensor, config, cal_result, buffer, buffer_size))
+        {
+                printf("acc_sensor_prepare() failed\n");
+                return false;
+        }
+
+        return true;
+}
+
+static const Detector *find_detector(int algo)
+{
+        for (size_t i = 0; i < sizeof(detectors) / sizeof(detectors[0]); i++)
+        {
+                if (detectors[i].algo == algo)
+                {
+                        return &detectors[i];
+                }
+        }
 
+        return NULL;
+}
+
+static uint16_t temperature_divisor(uint16_t temp)
+{
 	    uint16_t divisor = (-15 * temp) + 1600;
 	    if (divisor < 0 ) {
 	    	divisor = 1;
 	    } else {
 	    	divisor = round(divisor);
 		}
+	    return divisor;
+}
+
+static uint32_t single_plan_storage_size(const PrintDataConfig *print_data_config)
+{
+        return detection_plan_storage_size(print_data_config->num_points);
+}
+
+static void simple_threshold_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config)
+{
+        detection_plan_init(&state->plan, storage, print_data_config->num_points);
+        if (!detection_plan_build(&state->plan, print_data_config))
+        {
+                printf("detection plan: no storage for %u points\n", (unsigned)print_data_config->num_points);
+        }
+}
+
+uint32_t run_simple_threshold_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data)
+{
+        return threshold_detect(&state->plan, NULL, frame, print_data_config, proc_data);
+}
+
+static void tracked_threshold_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config)
+{
+        detection_plan_init(&state->tracked.plan, storage, print_data_config->num_points);
+        if (!detection_plan_build(&state->tracked.plan, print_data_config))
+        {
+                printf("detection plan: no storage for %u points\n", (unsigned)print_data_config->num_points);
+        }
+        tracking_gate_reset(&state->tracked.gate);
+}
+
+uint32_t run_tracked_threshold_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data)
+{
+        return threshold_detect(&state->tracked.plan, &state->tracked.gate, frame, print_data_config, proc_data);
+}
+
+// The target may have moved anywhere while re-calibrating
+static void tracked_threshold_reset(DetectorState *state)
+{
+        tracking_gate_reset(&state->tracked.gate);
+}
+
+static bool tracked_threshold_target_point(const DetectorState *state, int32_t *point)
+{
+        *point = state->tracked.gate.point;
+        return state->tracked.gate.locked;
+}
+
+static uint32_t threshold_detect(DetectionPlan *plan, TrackingGate *gate, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data)
+{
+	    float selected = 0;
+	    const acc_int16_complex_t *data = frame->data;
+	    uint16_t temp = frame->temp;
+
+	    // Distances and thresholds only change with the config
+	    if (detection_plan_is_stale(plan, print_data_config)) {
+	    	detection_plan_build(plan, print_data_config);
+	    }
+	    if (!plan->valid) {
+	    	return 0;
+	    }
+
+	    uint16_t divisor = temperature_divisor(temp);
 
 	    int num_points = print_data_config->num_points;
 	    int sweeps_per_frame = print_data_config->sweeps_per_frame;
-		if (data_length == num_points * sweeps_per_frame) {
-			uint32_t amplitudes[400] = {0};
-			float distances[400] = {0};
-
-			int first_threshold_index = 0;
-
-			float first_threshold_x = 0;
-			float first_threshold_y = 0;
-			float first_below_threshold_x = 0;
-			float first_below_threshold_y = 0;
-			float threshold_crossed = 0;
-			float max_amplitude = 0;
-
-			// Loop unrolling and precomputation
-
-			for (uint16_t sweep_index = 0; sweep_index < num_points; sweep_index++) {
-				uint32_t amplitude = (data[sweep_index].real * data[sweep_index].real + data[sweep_index].imag * data[sweep_index].imag) / divisor;
-			    amplitudes[sweep_index] = amplitude;
-			    if (amplitude > max_amplitude) {
-			    	max_amplitude = amplitude;
-			    }
-
-			    float distance = (sweep_index * rf_factor_step * print_data_config->step) + (print_data_config->start_point * rf_factor_step);
-			    distances[sweep_index] = distance;
-			    // First threshold check, make this outside the inner loop
-			    float threshold = 0;
-
-		        if ((distance >= print_data_config->x_intercepts[0]) && (distance <= print_data_config->x_intercepts[1]))
-		        {
-		            threshold = (distance * print_data_config->line1_slope) + print_data_config->y_inter_line1;
-		        }
-		        else if ((distance > print_data_config->x_intercepts[1]) && (distance <= print_data_config->x_intercepts[2]))
-		        {
-		            threshold = (distance * print_data_config->line2_slope) + print_data_config->y_inter_line2;
-		        }
-		        else if ((distance > print_data_config->x_intercepts[2]) && (distance <= print_data_config->x_intercepts[3]))
-		        {
-		            threshold = (distance * print_data_config->line3_slope) + print_data_config->y_inter_line3;
-		        }
-
-			    if (first_threshold_x == 0 && (amplitude - threshold) > 0) {
-			        first_threshold_x = distance;
-			        first_threshold_y = amplitude;
-			        first_threshold_index = sweep_index;
-			        threshold_crossed = threshold;
-
-			        if (sweep_index > 0) {
-			            first_below_threshold_x = distances[first_threshold_index - 1];
-			            first_below_threshold_y = amplitudes[first_threshold_index - 1];
-			        }
-			        break;
-			    }
+		if (frame->data_length == num_points * sweeps_per_frame) {
+			// Power is summed over every sweep in the frame, and thresholds are
+			// pre-scaled to that raw power so the scan has no per-bin divide
+			detection_plan_set_divisor(plan, divisor, sweeps_per_frame);
+			DetectionCrossing crossing;
+			if (gate == NULL) {
+				crossing = detection_plan_find_crossing(plan, data, sweeps_per_frame);
+			} else {
+				uint16_t first_bin;
+				uint16_t end_bin;
+				bool gated = tracking_gate_window(gate, print_data_config, &first_bin, &end_bin);
+
+				crossing = detection_plan_find_crossing_in(plan, data, sweeps_per_frame, first_bin, end_bin);
+
+				uint16_t bins_scanned = (crossing.index >= 0) ? (crossing.index - first_bin + 1) : (end_bin - first_bin);
+				if (!tracking_gate_update(gate, print_data_config, gated, first_bin, crossing.index, bins_scanned)) {
+					crossing.index = -1;
+				}
 			}
+			int first_threshold_index = (crossing.index > 0) ? crossing.index : 0;
 
 			if (first_threshold_index != 0)
 			{
-				selected = (first_below_threshold_x) + ((threshold_crossed - first_below_threshold_y )/ (first_threshold_y - first_below_threshold_y)) * (first_threshold_x - first_below_threshold_x);
+				selected = interpolate_crossing(plan, data, sweeps_per_frame, first_threshold_index, divisor, crossing.max_power, proc_data);
 				
-				// Apply lookup table corrections using helper function
-				float corrected_distance_mm = apply_distance_correction(selected * 1000); // Convert to mm
-				selected = corrected_distance_mm / 1000; // Convert back to meters
-				
-				uint32_t distance = (uint32_t)(selected * 10000);
+				uint32_t distance = correct_selected_distance(selected, temp);
 
 				proc_data->selected_distance = distance;
-				proc_data->divisor = (uint16_t)(divisor);
-				proc_data->first_threshold_x = (uint32_t)(first_threshold_x * 10000);
-				proc_data->first_threshold_y = (uint32_t)(first_threshold_y);
-				proc_data->max_amplitude = (uint32_t)(max_amplitude);
 
 				return distance;
 			}
@@ -460,64 +748,319 @@ uint32_t run_simple_threshold_algo(acc_int16_complex_t *data, uint16_t data_leng
 	return 0;
 }
 
-uint32_t run_delay_n_compare_algo(acc_int16_complex_t *data, uint16_t data_length, PrintDataConfig *print_data_config, uint16_t temp) {
-    float selected = 9999999;
-    int selected_amplitude = 9999999;
+static float interpolate_crossing(const DetectionPlan *plan, const acc_int16_complex_t *data, uint16_t sweeps_per_frame, int index, uint16_t divisor, uint32_t max_power, ProcessedData *proc_data)
+{
+	    // Only the crossing and the bin before it need amplitudes; powers are
+	    // summed over the sweeps, so one divide gives the amplitude of the mean
+	    uint32_t crossing_power[2];
+	    power_kernel_integrate(&data[index - 1], plan->stride, sweeps_per_frame, crossing_power, 2);
+	    uint32_t scale = (uint32_t)divisor * sweeps_per_frame;
+
+	    float max_amplitude = max_power / scale;
+	    float first_threshold_x = detection_plan_distance(plan, index);
+	    float first_threshold_y = crossing_power[1] / scale;
+	    float threshold_crossed = plan->thresholds[index];
+	    float first_below_threshold_x = detection_plan_distance(plan, index - 1);
+	    float first_below_threshold_y = crossing_power[0] / scale;
+
+	    float selected = (first_below_threshold_x) + ((threshold_crossed - first_below_threshold_y )/ (first_threshold_y - first_below_threshold_y)) * (first_threshold_x - first_below_threshold_x);
+
+	    proc_data->divisor = (uint16_t)(divisor);
+	    proc_data->first_threshold_x = (uint32_t)(first_threshold_x * 10000);
+	    proc_data->first_threshold_y = (uint32_t)(first_threshold_y);
+	    proc_data->max_amplitude = (uint32_t)(max_amplitude);
+
+	    return selected;
+}
 
-    uint16_t divisor = (-15 * temp) + 1600;
-    if (divisor < 0 ) {
-    	divisor = 1;
-    } else {
-    	divisor = round(divisor);
-	}
+// The coarse plan covers the whole range at the coarse step, the fine plan
+// only COARSE_FINE_FINE_POINTS; the fine subsweep moves but never grows
+static uint32_t coarse_fine_storage_size(const PrintDataConfig *print_data_config)
+{
+        PrintDataConfig coarse;
+        PrintDataConfig fine;
+        coarse_fine_subsweeps(print_data_config, print_data_config->start_point, &coarse, &fine);
 
-    if (data_length == print_data_config->num_points * print_data_config->sweeps_per_frame) {
-        float amplitudes[400] = {0};
-        float distances[400] = {0};
+        return detection_plan_storage_size(coarse.num_points) + detection_plan_storage_size(fine.num_points);
+}
 
-        int first_threshold_index = 0;
+static void coarse_fine_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config)
+{
+        PrintDataConfig coarse;
+        PrintDataConfig fine;
+        coarse_fine_subsweeps(print_data_config, print_data_config->start_point, &coarse, &fine);
+
+        // Plans are built on the first frame, once the subsweeps are known
+        memset(&state->coarse_fine, 0, sizeof(state->coarse_fine));
+        detection_plan_init(&state->coarse_fine.coarse, storage, coarse.num_points);
+        detection_plan_init(&state->coarse_fine.fine,
+                            (storage != NULL) ? (uint8_t *)storage + detection_plan_storage_size(coarse.num_points) : NULL,
+                            fine.num_points);
+}
 
-        uint16_t num_points = print_data_config->num_points; // Cache this
+static bool coarse_fine_update_config(DetectorState *state, acc_config_t *config, const PrintDataConfig *print_data_config)
+{
+        int32_t fine_start;
+
+        if (!state->coarse_fine.configured)
+        {
+                // No target yet: park the fine subsweep in the middle of the range
+                int32_t middle = print_data_config->start_point + (print_data_config->num_points * print_data_config->step) / 2;
+                fine_start = coarse_fine_fine_start(print_data_config, middle);
+        }
+        else if (state->coarse_fine.target_valid && !coarse_fine_covers(state->coarse_fine.fine_start, state->coarse_fine.target_point))
+        {
+                fine_start = coarse_fine_fine_start(print_data_config, state->coarse_fine.target_point);
+        }
+        else
+        {
+                return false;
+        }
 
-        int found_threshold_crossing = 0;
+        PrintDataConfig subsweeps[2];
+        coarse_fine_subsweeps(print_data_config, fine_start, &subsweeps[COARSE_FINE_SUBSWEEP_COARSE], &subsweeps[COARSE_FINE_SUBSWEEP_FINE]);
 
-        for (uint16_t sweep_index = 0; sweep_index < num_points; sweep_index++) {
-            float amplitude = ((data[sweep_index].real * data[sweep_index].real) + (data[sweep_index].imag * data[sweep_index].imag)) / divisor;
-//            if (amplitude > 650000) {
-//            	amplitude = 999999;
-//            }
-            amplitudes[sweep_index] = amplitude;
-            float distance = (sweep_index * 0.0025f) + (print_data_config->start * 0.0025f);
-            distances[sweep_index] = distance;
+        acc_config_num_subsweeps_set(config, 2);
+        for (uint8_t i = 0; i < 2; i++)
+        {
+                acc_config_subsweep_start_point_set(config, subsweeps[i].start_point, i);
+                acc_config_subsweep_num_points_set(config, subsweeps[i].num_points, i);
+                acc_config_subsweep_step_length_set(config, subsweeps[i].step, i);
+                acc_config_subsweep_profile_set(config, print_data_config->profile, i);
+                acc_config_subsweep_receiver_gain_set(config, print_data_config->receiver_gain, i);
+                acc_config_subsweep_prf_set(config, print_data_config->prf, i);
+                acc_config_subsweep_hwaas_set(config, print_data_config->ave, i);
+                acc_config_subsweep_phase_enhancement_set(config, true, i);
+        }
 
-            float threshold = 0;
+        state->coarse_fine.fine_start = fine_start;
+        state->coarse_fine.configured = true;
+        return true;
+}
 
-            if ((distance >= print_data_config->x_intercepts[0]) && (distance <= print_data_config->x_intercepts[1])) {
-                threshold = (distance * print_data_config->line1_slope) + print_data_config->y_inter_line1;
-            } else if ((distance >= print_data_config->x_intercepts[1]) && (distance <= print_data_config->x_intercepts[2])) {
-                threshold = (distance * print_data_config->line2_slope) + print_data_config->y_inter_line2;
-            }
+// The coarse subsweep decides whether and roughly where the threshold is
+// crossed. If the fine subsweep covers that stretch, the crossing is searched
+// again there, starting from the last coarse bin below threshold, and
+// interpolated at step 1; otherwise the coarse bins are interpolated.
+uint32_t run_coarse_fine_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data)
+{
+	    const acc_processing_metadata_t *meta = frame->proc_meta;
+	    DetectionPlan *coarse_plan = &state->coarse_fine.coarse;
+	    DetectionPlan *fine_plan = &state->coarse_fine.fine;
+	    int32_t fine_start = state->coarse_fine.fine_start;
+	    uint16_t temp = frame->temp;
+
+	    state->coarse_fine.target_valid = false;
+
+	    PrintDataConfig coarse;
+	    PrintDataConfig fine;
+	    coarse_fine_subsweeps(print_data_config, fine_start, &coarse, &fine);
+
+	    if (detection_plan_is_stale(coarse_plan, &coarse)) {
+	    	detection_plan_build(coarse_plan, &coarse);
+	    }
+	    if (detection_plan_is_stale(fine_plan, &fine)) {
+	    	detection_plan_build(fine_plan, &fine);
+	    }
+	    if (!coarse_plan->valid || !fine_plan->valid) {
+	    	return 0;
+	    }
 
-            if ((amplitude - threshold) > 0 && found_threshold_crossing == 0) {
-                found_threshold_crossing = 1;
-                first_threshold_index = sweep_index;
-            }
-        }
+	    int sweeps_per_frame = print_data_config->sweeps_per_frame;
+	    if (frame->data_length != sweeps_per_frame * meta->sweep_data_length ||
+	    	meta->subsweep_data_length[COARSE_FINE_SUBSWEEP_COARSE] != coarse.num_points ||
+	    	meta->subsweep_data_length[COARSE_FINE_SUBSWEEP_FINE] != fine.num_points) {
+	    	return 0;
+	    }
+
+	    const acc_int16_complex_t *coarse_data = &frame->data[meta->subsweep_data_offset[COARSE_FINE_SUBSWEEP_COARSE]];
+	    const acc_int16_complex_t *fine_data = &frame->data[meta->subsweep_data_offset[COARSE_FINE_SUBSWEEP_FINE]];
+	    coarse_plan->stride = meta->sweep_data_length;
+	    fine_plan->stride = meta->sweep_data_length;
+
+	    uint16_t divisor = temperature_divisor(temp);
+	    detection_plan_set_divisor(coarse_plan, divisor, sweeps_per_frame);
+	    detection_plan_set_divisor(fine_plan, divisor, sweeps_per_frame);
+
+	    DetectionCrossing crossing = detection_plan_find_crossing(coarse_plan, coarse_data, sweeps_per_frame);
+	    if (crossing.index <= 0) {
+	    	return 0;
+	    }
+
+	    int32_t crossing_point = coarse.start_point + crossing.index * (int32_t)coarse.step;
+	    int32_t below_point = crossing_point - (int32_t)coarse.step;
+	    state->coarse_fine.target_valid = true;
+	    state->coarse_fine.target_point = crossing_point;
+
+	    float selected;
+	    int32_t first_bin = below_point - fine_start;
+	    int32_t end_bin = crossing_point - fine_start + 1;
+	    bool refined = false;
+
+	    if (first_bin >= 0 && end_bin <= fine.num_points) {
+	    	DetectionCrossing fine_crossing = detection_plan_find_crossing_in(fine_plan, fine_data, sweeps_per_frame, first_bin, end_bin);
+	    	// A fine crossing on the first bin started before the coarse one did
+	    	refined = fine_crossing.index > first_bin;
+	    	if (refined) {
+	    		selected = interpolate_crossing(fine_plan, fine_data, sweeps_per_frame, fine_crossing.index, divisor, crossing.max_power, proc_data);
+	    	}
+	    }
+
+	    if (!refined) {
+	    	selected = interpolate_crossing(coarse_plan, coarse_data, sweeps_per_frame, crossing.index, divisor, crossing.max_power, proc_data);
+	    }
+
+	    uint32_t distance = correct_selected_distance(selected, temp);
+	    proc_data->selected_distance = distance;
+
+	    return distance;
+}
+
+// Same sub-bin interpolation and outputs as run_simple_threshold_algo(), with the
+// threshold set per bin by CA-CFAR (cfar.h) instead of the three threshold lines.
+// The plan only supplies bin distances; x_intercepts[0]..x_intercepts[3] still
+// bound the range searched.
+uint32_t run_cfar_algo(DetectorState *state, const DetectorFrame *frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data)
+{
+	    DetectionPlan *plan = &state->plan;
+	    uint16_t temp = frame->temp;
+
+	    if (detection_plan_is_stale(plan, print_data_config)) {
+	    	detection_plan_build(plan, print_data_config);
+	    }
+	    if (!plan->valid) {
+	    	return 0;
+	    }
+	    uint16_t divisor = temperature_divisor(temp);
+
+	    int num_points = print_data_config->num_points;
+	    int sweeps_per_frame = print_data_config->sweeps_per_frame;
+	    if (frame->data_length != num_points * sweeps_per_frame) {
+	    	return 0;
+	    }
+
+	    int first_bin = -1;
+	    int last_bin = -1;
+	    for (int i = 0; i < num_points; i++) {
+	    	float distance = detection_plan_distance(plan, i);
+	    	if (distance >= print_data_config->x_intercepts[0] && distance <= print_data_config->x_intercepts[3]) {
+	    		first_bin = (first_bin < 0) ? i : first_bin;
+	    		last_bin = i;
+	    	}
+	    }
+	    if (first_bin < 0) {
+	    	return 0;
+	    }
+
+	    CfarCrossing crossing = cfar_find_crossing(frame->data, num_points, sweeps_per_frame, first_bin, last_bin);
+	    if (crossing.index <= 0) {
+	    	return 0;
+	    }
+
+	    int first_threshold_index = crossing.index;
+	    // CFAR powers are summed over the sweeps, like the detection plan's
+	    uint32_t scale = (uint32_t)divisor * sweeps_per_frame;
+	    float max_amplitude = crossing.max_power / scale;
+	    float first_threshold_x = detection_plan_distance(plan, first_threshold_index);
+	    float first_threshold_y = crossing.power / scale;
+	    float threshold_crossed = (float)crossing.threshold / scale;
+	    float first_below_threshold_x = detection_plan_distance(plan, first_threshold_index - 1);
+	    float first_below_threshold_y = crossing.prev_power / scale;
+
+	    float selected = first_threshold_x;
+	    if (first_threshold_y > first_below_threshold_y) {
+	    	selected = (first_below_threshold_x) + ((threshold_crossed - first_below_threshold_y )/ (first_threshold_y - first_below_threshold_y)) * (first_threshold_x - first_below_threshold_x);
+	    }
+
+	    uint32_t distance = correct_selected_distance(selected, temp);
+
+	    proc_data->selected_distance = distance;
+	    proc_data->divisor = (uint16_t)(divisor);
+	    proc_data->first_threshold_x = (uint32_t)(first_threshold_x * 10000);
+	    proc_data->first_threshold_y = (uint32_t)(first_threshold_y);
+	    proc_data->max_amplitude = (uint32_t)(max_amplitude);
+
+	    return distance;
+}
+
+// Frame view for the delay-and-compare detector. Amplitudes and distances are
+// derived per bin on demand, so the detector keeps no frame-sized arrays.
+typedef struct {
+    const acc_int16_complex_t *data;
+    uint16_t num_points;
+    uint16_t sweeps_per_frame;
+    uint32_t scale; // Temperature divisor * sweeps_per_frame
+    int start;
+} DelayFrame;
+
+// Integrated amplitude of one bin; bin -1 (before the sweep) reads as 0
+static float delay_amplitude(const DelayFrame *frame, int index) {
+    uint32_t power = 0;
+    if (index >= 0) {
+        power_kernel_integrate(&frame->data[index], frame->num_points, frame->sweeps_per_frame, &power, 1);
+    }
+    return power / frame->scale;
+}
+
+// Same expression as detection_plan_build_delay_n_compare()
+static float delay_distance(const DelayFrame *frame, int index) {
+    return (index * 0.0025f) + (frame->start * 0.0025f);
+}
+
+static void delay_n_compare_init(DetectorState *state, void *storage, const PrintDataConfig *print_data_config) {
+    detection_plan_init(&state->plan, storage, print_data_config->num_points);
+    if (!detection_plan_build_delay_n_compare(&state->plan, print_data_config)) {
+        printf("detection plan: no storage for %u points\n", (unsigned)print_data_config->num_points);
+    }
+}
+
+uint32_t run_delay_n_compare_algo(DetectorState *state, const DetectorFrame *detector_frame, const PrintDataConfig *print_data_config, ProcessedData *proc_data) {
+    float selected = 9999999;
+    int selected_amplitude = 9999999;
+    int detected = 0;
+    DetectionPlan *delay_plan = &state->plan;
+    const acc_int16_complex_t *data = detector_frame->data;
+    uint16_t temp = detector_frame->temp;
+
+    uint16_t divisor = temperature_divisor(temp);
+
+    if (detection_plan_is_stale(delay_plan, print_data_config)) {
+    	detection_plan_build_delay_n_compare(delay_plan, print_data_config);
+    }
+
+    if (delay_plan->valid && detector_frame->data_length == print_data_config->num_points * print_data_config->sweeps_per_frame) {
+        DelayFrame frame = {
+            .data = data,
+            .num_points = print_data_config->num_points,
+            .sweeps_per_frame = print_data_config->sweeps_per_frame,
+            .scale = (uint32_t)divisor * print_data_config->sweeps_per_frame,
+            .start = print_data_config->start
+        };
+        uint16_t num_points = frame.num_points; // Cache this
+
+        // Power is summed over every sweep in the frame, and thresholds are
+        // pre-scaled to that raw power so the scan has no per-bin divide
+        detection_plan_set_divisor(delay_plan, divisor, frame.sweeps_per_frame);
+        DetectionCrossing crossing = detection_plan_find_crossing(delay_plan, data, frame.sweeps_per_frame);
+        int found_threshold_crossing = (crossing.index >= 0);
+        int first_threshold_index = found_threshold_crossing ? crossing.index : 0;
+        float first_threshold_distance = delay_distance(&frame, first_threshold_index);
 
         int max_amplitude_index = 0;
         float max_amplitude = 0;
 
-        if (found_threshold_crossing && ((distances[first_threshold_index] >= print_data_config->x_intercepts[1]) && (distances[first_threshold_index] <= print_data_config->x_intercepts[2]))) {
-        	max_amplitude = amplitudes[first_threshold_index];
+        if (found_threshold_crossing && ((first_threshold_distance >= print_data_config->x_intercepts[1]) && (first_threshold_distance <= print_data_config->x_intercepts[2]))) {
+        	max_amplitude = delay_amplitude(&frame, first_threshold_index);
 
             for (uint16_t i = first_threshold_index; i < first_threshold_index + print_data_config->peak_search_range && i < num_points; i++) {
-                if (amplitudes[i] > max_amplitude) {
-                    max_amplitude = amplitudes[i];
+                float amplitude = delay_amplitude(&frame, i);
+                if (amplitude > max_amplitude) {
+                    max_amplitude = amplitude;
                     max_amplitude_index = i;
                 }
             }
 
-//            float max_amplitude_distance = distances[max_amplitude_index];
+//            float max_amplitude_distance = delay_distance(&frame, max_amplitude_index);
             float new_threshold = max_amplitude / print_data_config->threshold_divisor;
 
             float new_threshold_crossing_x = 0.0f;
@@ -529,18 +1072,25 @@ uint32_t run_delay_n_compare_algo(acc_int16_complex_t *data, uint16_t data_lengt
             }
 
 			for (uint16_t i = range_start; i < max_amplitude_index; i++) {
-				if (amplitudes[i] >new_threshold && new_threshold_crossing_index == 0) {
+				if (delay_amplitude(&frame, i) > new_threshold && new_threshold_crossing_index == 0) {
 					new_threshold_crossing_index = i;
 					break;
 				}
 			}
 
-            float slope = (float)(amplitudes[new_threshold_crossing_index] - amplitudes[new_threshold_crossing_index - 1]) / (distances[new_threshold_crossing_index] - distances[new_threshold_crossing_index - 1]);
-            float y_intercept = -((slope * distances[new_threshold_crossing_index]) - amplitudes[new_threshold_crossing_index]);
+            // Bins are recomputed rather than kept, only these two are needed here
+            float crossing_amplitude = delay_amplitude(&frame, new_threshold_crossing_index);
+            float before_amplitude = delay_amplitude(&frame, new_threshold_crossing_index - 1);
+            float crossing_distance = delay_distance(&frame, new_threshold_crossing_index);
+            float before_distance = delay_distance(&frame, new_threshold_crossing_index - 1);
+
+            float slope = (float)(crossing_amplitude - before_amplitude) / (crossing_distance - before_distance);
+            float y_intercept = -((slope * crossing_distance) - crossing_amplitude);
 
             selected = (new_threshold - y_intercept) / slope;
             selected_amplitude = new_threshold;
-        } else if (found_threshold_crossing && ((distances[first_threshold_index] >= print_data_config->x_intercepts[0]) && (distances[first_threshold_index] < print_data_config->x_intercepts[1]))) {
+            detected = 1;
+        } else if (found_threshold_crossing && ((first_threshold_distance >= print_data_config->x_intercepts[0]) && (first_threshold_distance < print_data_config->x_intercepts[1]))) {
 //            for (uint16_t i = print_data_config->x_intercepts[0]; i < print_data_config->x_intercepts[1]; i++) {
 //                if (amplitudes[i] > max_amplitude) {
 //                    max_amplitude = amplitudes[i];
@@ -549,13 +1099,26 @@ uint32_t run_delay_n_compare_algo(acc_int16_complex_t *data, uint16_t data_lengt
 //            }
 
 
-            selected = distances[max_amplitude_index];
+            selected = delay_distance(&frame, max_amplitude_index);
             selected_amplitude = max_amplitude;
+            detected = 1;
         }
+
+        if (detected) {
+            proc_data->divisor = divisor;
+            proc_data->first_threshold_x = (uint32_t)(first_threshold_distance * 10000);
+            proc_data->first_threshold_y = (uint32_t)(delay_amplitude(&frame, first_threshold_index));
+            proc_data->max_amplitude = (uint32_t)(max_amplitude);
+        }
+    }
+
+    if (!detected) {
+        return 0;
     }
 
     selected = selected / print_data_config->rf_factor;
-    uint32_t distance = (uint32_t)(selected * 1000);
+    uint32_t distance = correct_selected_distance(selected, temp);
+    proc_data->selected_distance = distance;
 
     return distance;
 
@@ -587,6 +1150,12 @@ static void cleanup(acc_config_t *config, acc_processing_t *processing,
         {
                 acc_integration_mem_free(buffer);
         }
+
+        if (detector_storage != NULL)
+        {
+                acc_integration_mem_free(detector_storage);
+                detector_storage = NULL;
+        }
 }
 
 // Helper function to check if lookup tables are available and valid
@@ -598,20 +1167,106 @@ static bool lookup_tables_available(void) {
 #endif
 }
 
+#ifdef LOOKUP_TABLE_FIXED_POINT
+// Distance correction in 0.1 mm integer units using a fixed-point lookup table
+static uint32_t apply_distance_correction_q(uint32_t raw_distance_q, float temperature_c) {
+    if (lut_download_active()) {
+        // Downloaded tables are float
+        return (uint32_t)(apply_distance_correction(raw_distance_q * 0.1f, temperature_c) * 10.0f);
+    }
+    
+#ifdef ERROR_TABLE_SIZE
+    // The error correction table is float only, keep the float path for it
+    return (uint32_t)(apply_distance_correction(raw_distance_q * 0.1f, temperature_c) * 10.0f);
+#else
+    return getNearestDistanceQ(raw_distance_q);
+#endif
+}
+#endif
+
+#if defined(LOOKUP_TABLE_SIZE) && !defined(LOOKUP_TABLE_FUSED)
+// Position-distance lookup, temperature-indexed when the table has a temperature axis
+static float lookup_distance_at(float position, float temperature_c) {
+#ifdef LOOKUP_TABLE_2D
+    return getNearestDistance2D(position, temperature_c);
+#else
+    (void)temperature_c;
+    return getNearestDistance(position);
+#endif
+}
+#endif
+
+#ifdef CAN_FD_TELEMETRY
+static void put_u32(uint8_t *out, uint32_t value)
+{
+        out[0] = (value >> 24) & 0xFF;
+        out[1] = (value >> 16) & 0xFF;
+        out[2] = (value >> 8) & 0xFF;
+        out[3] = value & 0xFF;
+}
+
+static void put_u16(uint8_t *out, uint16_t value)
+{
+        out[0] = (value >> 8) & 0xFF;
+        out[1] = value & 0xFF;
+}
+
+static bool send_fd_telemetry(uint32_t sequence, uint32_t avg_distance, uint32_t distance, uint16_t temp,
+                              const ProcessedData *proc_data)
+{
+        uint8_t data[CAN_FD_TELEMETRY_LENGTH];
+
+        put_u32(&data[0], avg_distance);
+        put_u16(&data[4], proc_data->divisor);
+        put_u16(&data[6], temp);
+        put_u32(&data[8], proc_data->max_amplitude);
+        put_u32(&data[12], proc_data->first_threshold_y);
+        put_u32(&data[16], distance);
+        put_u32(&data[20], proc_data->first_threshold_x);
+        put_u32(&data[24], sequence);
+        put_u32(&data[28], HAL_GetTick());
+
+        return can_tx_queue_send_fd(CAN_FD_TELEMETRY_ID, data, CAN_FD_TELEMETRY_LENGTH);
+}
+#endif
+
+// Detector distance (m) to the 0.1 mm units sent on 0x13, lookup table corrected
+static uint32_t correct_selected_distance(float selected_m, uint16_t temp) {
+#ifdef LOOKUP_TABLE_FIXED_POINT
+    // Integer table works directly in the 0.1 mm units sent on 0x13
+    return apply_distance_correction_q((uint32_t)(selected_m * 10000 + 0.5f), (int16_t)temp);
+#else
+    // Apply lookup table corrections using helper function
+    float corrected_distance_mm = apply_distance_correction(selected_m * 1000, (int16_t)temp); // Convert to mm
+    selected_m = corrected_distance_mm / 1000; // Convert back to meters
+
+    return (uint32_t)(selected_m * 10000);
+#endif
+}
+
 // Enhanced distance correction using generated lookup tables
-static float apply_distance_correction(float raw_distance_mm) {
+static float apply_distance_correction(float raw_distance_mm, float temperature_c) {
+    if (lut_download_active()) {
+        // A table downloaded over CAN replaces the compiled tables until reset
+        return lut_download_lookup(raw_distance_mm);
+    }
+    
     if (!lookup_tables_available()) {
         // No lookup tables available, return raw distance
         return raw_distance_mm;
     }
     
-#ifdef ERROR_TABLE_SIZE
+#if defined(LOOKUP_TABLE_FUSED)
+    // Error correction, lookup and the 2mm arbitration are precomputed into one table
+    (void)temperature_c;
+    return getNearestDistance(raw_distance_mm);
+#elif defined(ERROR_TABLE_SIZE)
     // Apply error correction first
     float corrected_distance = applyCorrectedDistance(raw_distance_mm);
     
     // Optionally validate with position-distance lookup
     #ifdef LOOKUP_TABLE_SIZE
-    float lookup_distance = getNearestDistance(corrected_distance);
+    float lookup_distance = lookup_distance_at(corrected_distance, temperature_c);
     if (lookup_distance > 0) {
         // Use lookup result if significantly different and valid
         float difference = (lookup_distance > corrected_distance) ? 
@@ -629,9 +1284,10 @@ static float apply_distance_correction(float raw_distance_mm) {
 #else
     // Only position-distance lookup available
     #ifdef LOOKUP_TABLE_SIZE
-    float lookup_distance = getNearestDistance(raw_distance_mm);
+    float lookup_distance = lookup_distance_at(raw_distance_mm, temperature_c);
     return (lookup_distance > 0) ? lookup_distance : raw_distance_mm;
     #else
+    (void)temperature_c;
     return raw_distance_mm;
     #endif
 #endif
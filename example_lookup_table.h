@@ -26,102 +26,100 @@ const float distances[LOOKUP_TABLE_SIZE] = {
     50.12f
 };
 
-// Function to get distance for a given position (exact match)
-float getDistanceForPosition(float position) {
-    for (int i = 0; i < LOOKUP_TABLE_SIZE; i++) {
-        if (positions[i] == position) {
-            return distances[i];
-        }
+// Inverse table size (distances sorted, duplicates averaged)
+#define INVERSE_TABLE_SIZE 5
+#define INVERSE_DISTANCE_MIN 10.45f
+#define INVERSE_DISTANCE_MAX 50.12f
+
+// Inverse distance array (mm), strictly increasing
+const float inverse_distances[INVERSE_TABLE_SIZE] = {
+    10.45f,
+    20.78f,
+    30.22f,
+    40.03f,
+    50.12f
+};
+
+// Inverse position array (mm)
+const float inverse_positions[INVERSE_TABLE_SIZE] = {
+    10.50f,
+    20.75f,
+    30.25f,
+    40.00f,
+    50.15f
+};
+
+// Find the interpolation segment for a key (binary search)
+// Returns i in [0, size - 2] with keys[i] <= key < keys[i + 1]; keys outside
+// the table land in the first or last segment. keys[] must be sorted ascending.
+static inline int lookupBracketIndex(const float *keys, int size, float key) {
+    int base = 0;
+    int len = size - 1;
+    
+    while (len > 1) {
+        int half = len / 2;
+        base = (keys[base + half] <= key) ? base + half : base;
+        len -= half;
     }
-    return -1.0f; // Position not found
+    
+    return base;
 }
 
-// Function to get nearest distance for a position (interpolated)
-float getNearestDistance(float position) {
-    if (LOOKUP_TABLE_SIZE == 0) return -1.0f;
+// Interpolate ys[] at x over sorted xs[]
+// Exact matches and out-of-range inputs are handled by clamping the segment
+// weight, so the table is only searched once.
+static inline float lookupInterpolate(const float *xs, const float *ys, int size, float x) {
+    if (size == 0) return -1.0f;
+    if (size == 1) return ys[0];
     
-    // Check for exact match first
-    for (int i = 0; i < LOOKUP_TABLE_SIZE; i++) {
-        if (positions[i] == position) {
-            return distances[i];
-        }
-    }
+    int i = lookupBracketIndex(xs, size, x);
+    float dx = xs[i + 1] - xs[i];
+    float t = (dx > 0.0f) ? (x - xs[i]) / dx : 0.0f;
+    t = (t < 0.0f) ? 0.0f : t;
+    t = (t > 1.0f) ? 1.0f : t;
     
-    // Find the two closest points for interpolation
-    if (position <= positions[0]) {
-        return distances[0]; // Return first value
-    }
-    if (position >= positions[LOOKUP_TABLE_SIZE - 1]) {
-        return distances[LOOKUP_TABLE_SIZE - 1]; // Return last value
+    // Weighted form returns ys[i] / ys[i + 1] exactly at t == 0 / t == 1
+    return ys[i] * (1.0f - t) + ys[i + 1] * t;
+}
+
+// Function to get distance for a given position (exact match)
+float getDistanceForPosition(float position) {
+    if (LOOKUP_TABLE_SIZE == 1) {
+        return (positions[0] == position) ? distances[0] : -1.0f;
     }
     
-    // Linear interpolation between two points
-    for (int i = 0; i < LOOKUP_TABLE_SIZE - 1; i++) {
-        if (position > positions[i] && position < positions[i + 1]) {
-            float x1 = positions[i];
-            float y1 = distances[i];
-            float x2 = positions[i + 1];
-            float y2 = distances[i + 1];
-            
-            // Linear interpolation formula
-            float interpolated = y1 + (y2 - y1) * (position - x1) / (x2 - x1);
-            return interpolated;
-        }
+    int i = lookupBracketIndex(positions, LOOKUP_TABLE_SIZE, position);
+    if (positions[i] == position) {
+        return distances[i];
     }
-    
-    return -1.0f; // Should not reach here
+    if (positions[i + 1] == position) {
+        return distances[i + 1];
+    }
+    return -1.0f; // Position not found
+}
+
+// Function to get nearest distance for a position (interpolated)
+float getNearestDistance(float position) {
+    return lookupInterpolate(positions, distances, LOOKUP_TABLE_SIZE, position);
 }
 
 // Function to get the closest position index in the lookup table
 int getClosestPositionIndex(float position) {
-    int closest_index = 0;
-    float min_diff = (position > positions[0]) ? position - positions[0] : positions[0] - position;
+    if (LOOKUP_TABLE_SIZE == 1) return 0;
     
-    for (int i = 1; i < LOOKUP_TABLE_SIZE; i++) {
-        float diff = (position > positions[i]) ? position - positions[i] : positions[i] - position;
-        if (diff < min_diff) {
-            min_diff = diff;
-            closest_index = i;
-        }
-    }
+    int i = lookupBracketIndex(positions, LOOKUP_TABLE_SIZE, position);
+    float diff_lo = (position > positions[i]) ? position - positions[i] : positions[i] - position;
+    float diff_hi = (position > positions[i + 1]) ? position - positions[i + 1] : positions[i + 1] - position;
     
-    return closest_index;
+    return (diff_hi < diff_lo) ? i + 1 : i;
 }
 
 // Function to get the nearest position given a distance (reverse lookup)
+// Searches the sorted inverse table, so non-monotonic sensor error is handled
 float getNearestPosition(float distance) {
-    if (LOOKUP_TABLE_SIZE == 0) return -1.0f;
-    
-    // Check for exact match first
-    for (int i = 0; i < LOOKUP_TABLE_SIZE; i++) {
-        if (distances[i] == distance) {
-            return positions[i];
-        }
-    }
-    
-    // Find the two closest distances for interpolation
-    if (distance <= distances[0]) {
-        return positions[0]; // Return first position
-    }
-    if (distance >= distances[LOOKUP_TABLE_SIZE - 1]) {
-        return positions[LOOKUP_TABLE_SIZE - 1]; // Return last position
-    }
-    
-    // Linear interpolation between two points using distance as input
-    for (int i = 0; i < LOOKUP_TABLE_SIZE - 1; i++) {
-        if (distance > distances[i] && distance < distances[i + 1]) {
-            float x1 = distances[i];    // distance1
-            float y1 = positions[i];    // position1
-            float x2 = distances[i + 1]; // distance2
-            float y2 = positions[i + 1]; // position2
-            
-            // Linear interpolation formula (reverse lookup)
-            float interpolated = y1 + (y2 - y1) * (distance - x1) / (x2 - x1);
-            return interpolated;
-        }
-    }
-    
-    return -1.0f; // Should not reach here
+    if (distance <= INVERSE_DISTANCE_MIN) return inverse_positions[0];
+    if (distance >= INVERSE_DISTANCE_MAX) return inverse_positions[INVERSE_TABLE_SIZE - 1];
+    return lookupInterpolate(inverse_distances, inverse_positions, INVERSE_TABLE_SIZE, distance);
 }
 
 // Function to get the closest distance index in the lookup table (reverse search)
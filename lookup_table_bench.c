@@ -0,0 +1,170 @@
+// Lookup Table Benchmark
+// Host benchmark of the generated lookup_table.h search (lookupInterpolate(),
+// one binary search) against the linear scans it replaced, for table sizes
+// from 10 to 100k entries. Both are cross-checked on every query.
+//
+// Build and run:
+//   gcc -O2 lookup_table_bench.c -o lookup_table_bench -lm && ./lookup_table_bench
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "example_lookup_table.h"
+
+// Lookups per table size, spread so every size runs in about the same time
+#define BENCH_SCANNED_ENTRIES (200000000.0)
+#define BENCH_MIN_QUERIES     (1000)
+#define BENCH_MAX_QUERIES     (1000000)
+
+// getNearestDistance() before the binary search, over caller-provided arrays
+static float linear_interpolate(const float *xs, const float *ys, int size, float x)
+{
+        if (size == 0) return -1.0f;
+
+        for (int i = 0; i < size; i++)
+        {
+                if (xs[i] == x)
+                {
+                        return ys[i];
+                }
+        }
+
+        if (x <= xs[0])
+        {
+                return ys[0];
+        }
+        if (x >= xs[size - 1])
+        {
+                return ys[size - 1];
+        }
+
+        for (int i = 0; i < size - 1; i++)
+        {
+                if (x > xs[i] && x < xs[i + 1])
+                {
+                        return ys[i] + (ys[i + 1] - ys[i]) * (x - xs[i]) / (xs[i + 1] - xs[i]);
+                }
+        }
+
+        return -1.0f;
+}
+
+static double now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static float uniform(float lo, float hi)
+{
+        return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+// Sensor-like table: 1 mm bins with a small, non-monotonic error
+static void fill_table(float *positions, float *dists, int size)
+{
+        for (int i = 0; i < size; i++)
+        {
+                positions[i] = 50.0f + (float)i + uniform(-0.2f, 0.2f);
+                dists[i]     = positions[i] + 2.0f * sinf((float)i * 0.05f) + uniform(-0.5f, 0.5f);
+        }
+}
+
+int main(void)
+{
+        static const int sizes[] = {10, 100, 1000, 10000, 100000};
+        volatile float   sink    = 0.0f;
+        int              failed  = 0;
+
+        srand(1);
+        printf("%8s %10s %14s %14s %10s %12s\n", "size", "queries", "linear ns", "binary ns", "speedup", "max diff mm");
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+                int   size      = sizes[s];
+                int   queries   = (int)(BENCH_SCANNED_ENTRIES / size);
+                float *xs       = malloc(sizeof(float) * size);
+                float *ys       = malloc(sizeof(float) * size);
+                float *query    = NULL;
+                float max_diff  = 0.0f;
+
+                queries = (queries < BENCH_MIN_QUERIES) ? BENCH_MIN_QUERIES : queries;
+                queries = (queries > BENCH_MAX_QUERIES) ? BENCH_MAX_QUERIES : queries;
+                query   = malloc(sizeof(float) * queries);
+                if (xs == NULL || ys == NULL || query == NULL)
+                {
+                        printf("allocation failed\n");
+                        return EXIT_FAILURE;
+                }
+
+                fill_table(xs, ys, size);
+
+                // A few inputs outside the table and on exact knots, the rest inside
+                for (int q = 0; q < queries; q++)
+                {
+                        int kind = q % 16;
+
+                        if (kind == 0)
+                        {
+                                query[q] = xs[0] - uniform(0.0f, 10.0f);
+                        }
+                        else if (kind == 1)
+                        {
+                                query[q] = xs[size - 1] + uniform(0.0f, 10.0f);
+                        }
+                        else if (kind == 2)
+                        {
+                                query[q] = xs[rand() % size];
+                        }
+                        else
+                        {
+                                query[q] = uniform(xs[0], xs[size - 1]);
+                        }
+                }
+
+                double start = now_ns();
+                for (int q = 0; q < queries; q++)
+                {
+                        sink += linear_interpolate(xs, ys, size, query[q]);
+                }
+                double linear_ns = (now_ns() - start) / queries;
+
+                start = now_ns();
+                for (int q = 0; q < queries; q++)
+                {
+                        sink += lookupInterpolate(xs, ys, size, query[q]);
+                }
+                double binary_ns = (now_ns() - start) / queries;
+
+                for (int q = 0; q < queries; q++)
+                {
+                        float diff = fabsf(linear_interpolate(xs, ys, size, query[q]) -
+                                           lookupInterpolate(xs, ys, size, query[q]));
+
+                        max_diff = (diff > max_diff) ? diff : max_diff;
+                }
+
+                // The two interpolation formulas round differently: allow a few ulp
+                failed |= (max_diff > 4.0f * FLT_EPSILON * fabsf(ys[size - 1]));
+
+                printf("%8d %10d %14.1f %14.1f %9.1fx %12.6f\n", size, queries, linear_ns, binary_ns,
+                       linear_ns / binary_ns, max_diff);
+
+                free(xs);
+                free(ys);
+                free(query);
+        }
+
+        (void)sink;
+        if (failed)
+        {
+                printf("FAILED: binary search disagrees with the linear scan\n");
+                return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+}
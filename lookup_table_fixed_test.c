@@ -0,0 +1,91 @@
+// Fixed-Point Lookup Table Test
+// Host check that a generated fixed-point header (LOOKUP_TABLE_FIXED_POINT)
+// stays within 1 LSB (0.1 mm) of the float path for the same table, the
+// requirement write_fixed_point_c_header() enforces with its Python model.
+// Both sides are converted as correct_selected_distance() does: the float
+// path truncates getNearestDistance() to 0.1 mm, the fixed path rounds the
+// input to 0.1 mm and calls getNearestDistanceQ(). Inputs run every 0.01 mm
+// from one bin below the table to one bin above it.
+//
+// LUT_FLOAT_HEADER and LUT_FIXED_HEADER are the uniform and fixed layouts
+// exported from one compiled table, under different names so their include
+// guards differ. lookup_table_fixed_test.py generates a pair and runs this.
+//
+// Build and run:
+//   gcc -O2 -DLUT_FLOAT_HEADER='"lut_float.h"' -DLUT_FIXED_HEADER='"lut_fixed.h"' lookup_table_fixed_test.c -o lookup_table_fixed_test && ./lookup_table_fixed_test
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include LUT_FLOAT_HEADER
+
+// Both headers define getNearestDistance(); keep the float one under its name
+#undef LOOKUP_TABLE_SIZE
+#define getNearestDistance fixed_getNearestDistance
+#include LUT_FIXED_HEADER
+#undef getNearestDistance
+
+#ifndef LOOKUP_TABLE_FIXED_POINT
+#error "LUT_FIXED_HEADER is not a fixed-point layout"
+#endif
+
+#define TEST_MAX_ERROR_LSB (1)
+
+// correct_selected_distance() without LOOKUP_TABLE_FIXED_POINT, from mm
+static uint32_t float_path_q(float position_mm)
+{
+        float selected_m = getNearestDistance(position_mm) / 1000;
+
+        return (uint32_t)(selected_m * 10000);
+}
+
+// correct_selected_distance() with LOOKUP_TABLE_FIXED_POINT, from mm
+static uint32_t fixed_path_q(float position_mm)
+{
+        float selected_m = position_mm / 1000;
+
+        return getNearestDistanceQ((uint32_t)(selected_m * 10000 + 0.5f));
+}
+
+int main(void)
+{
+        // One bin either side of the grid, as fixed_point_table() checks
+        float    step     = 1.0f / LOOKUP_TABLE_INV_STEP;
+        float    first_mm = LOOKUP_TABLE_ORIGIN - step;
+        float    last_mm  = LOOKUP_TABLE_ORIGIN + step * LOOKUP_TABLE_SIZE;
+        int32_t  worst    = 0;
+        float    worst_mm = 0.0f;
+        uint32_t inputs   = 0;
+
+        first_mm = (first_mm < 0.0f) ? 0.0f : first_mm;
+
+        for (int32_t k = 0; first_mm + k * 0.01f <= last_mm; k++)
+        {
+                float   position_mm = first_mm + k * 0.01f;
+                int32_t error       = (int32_t)fixed_path_q(position_mm) - (int32_t)float_path_q(position_mm);
+
+                error = (error < 0) ? -error : error;
+                if (error > worst)
+                {
+                        worst    = error;
+                        worst_mm = position_mm;
+                }
+                inputs++;
+        }
+
+        printf("%u inputs from %.2f to %.2f mm, max deviation %d LSB", (unsigned)inputs, first_mm, last_mm,
+               (int)worst);
+        if (worst > 0)
+        {
+                printf(" (first at %.2f mm)", worst_mm);
+        }
+        printf("\n");
+
+        if (worst > TEST_MAX_ERROR_LSB)
+        {
+                printf("FAILED: fixed-point path deviates more than %d LSB from the float path\n", TEST_MAX_ERROR_LSB);
+                return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+}
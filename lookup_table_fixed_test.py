@@ -0,0 +1,88 @@
+"""
+Fixed-Point Lookup Table Test
+Exports sensor-like tables in the uniform (float) and fixed-point layouts,
+compiles lookup_table_fixed_test.c against each pair with gcc and runs it, so
+the generated getNearestDistanceQ() is checked against the float
+getNearestDistance() path in C, not only through the Python model in
+LookupTable.fixed_point_table().
+
+Run:
+    python3 lookup_table_fixed_test.py
+"""
+
+import math
+import os
+import random
+import shutil
+import subprocess
+import tempfile
+import unittest
+
+from lookup_table_gui import LookupTable, LookupTableGUI
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TEST_SOURCE = os.path.join(HERE, "lookup_table_fixed_test.c")
+
+
+def sensor_table(bin_size, start=60.0, span=1400.0):
+    """Compiled table with a smooth, non-monotonic sensor error and noise"""
+    rng = random.Random(1)
+    lut = LookupTable("fixed_test")
+    positions = [start + span * i / 20000.0 for i in range(20001)]
+    distances = [p + 1.5 * math.sin(p / 37.0) + 0.4 * math.sin(p / 5.3) + rng.uniform(-0.3, 0.3)
+                 for p in positions]
+    lut.add_data(positions, distances)
+    lut.compile(bin_size=bin_size)
+    return lut
+
+
+@unittest.skipUnless(shutil.which("gcc"), "needs gcc")
+class FixedPointHeaderTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dir)
+
+    def run_c_test(self, lut):
+        """Export both layouts of lut, build and run the C test; returns its output"""
+        float_header = os.path.join(self.dir, "lut_float.h")
+        fixed_header = os.path.join(self.dir, "lut_fixed.h")
+        binary = os.path.join(self.dir, "lookup_table_fixed_test")
+
+        # Different names give the two headers different include guards
+        name = lut.name
+        lut.name = f"{name}_float"
+        LookupTableGUI.write_uniform_c_header(None, float_header, lut)
+        lut.name = f"{name}_fixed"
+        LookupTableGUI.write_fixed_point_c_header(None, fixed_header, lut)
+        lut.name = name
+
+        subprocess.run(["gcc", "-O2", "-Wall", "-I", self.dir,
+                        '-DLUT_FLOAT_HEADER="lut_float.h"', '-DLUT_FIXED_HEADER="lut_fixed.h"',
+                        TEST_SOURCE, "-o", binary], check=True)
+        result = subprocess.run([binary], capture_output=True, text=True)
+        self.assertEqual(result.returncode, 0, result.stdout)
+        return result.stdout
+
+    def test_within_one_lsb(self):
+        for bin_size in (0.5, 1.0, 2.0):
+            with self.subTest(bin_size=bin_size):
+                lut = sensor_table(bin_size)
+                self.assertLessEqual(lut.fixed_point_table()['max_error_lsb'], 1)
+                self.run_c_test(lut)
+
+    def test_table_above_one_lsb_is_rejected(self):
+        # Knots off the 10 mm grid (example_lookup_table.h): resampling moves the
+        # last knot by 0.35 mm, far more than 1 LSB
+        lut = LookupTable("fixed_test")
+        lut.compiled_positions = [10.50, 20.75, 30.25, 40.00, 50.15]
+        lut.compiled_distances = [10.45, 20.78, 30.22, 40.03, 50.12]
+        lut.metadata['bin_size'] = 10.0
+        self.assertGreater(lut.fixed_point_table()['max_error_lsb'], 1)
+        with self.assertRaises(ValueError):
+            LookupTableGUI.write_fixed_point_c_header(None, os.path.join(self.dir, "lut_fixed.h"), lut)
+
+
+if __name__ == "__main__":
+    unittest.main()
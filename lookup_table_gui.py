@@ -4,7 +4,9 @@ Loads sensor comparison data files and creates lookup tables for Python-side cor
 """
 
 import os
+import re
 import csv
+import bisect
 import json
 import datetime
 import tkinter as tk
@@ -13,31 +15,71 @@ from tkinter import ttk, filedialog, messagebox
 import numpy as np
 import matplotlib.pyplot as plt
 from matplotlib.backends.backend_tkagg import FigureCanvasTkAgg, NavigationToolbar2Tk
+from lut_batch import BatchCorrector, inverse_table
+
+
+def load_error_correction_table(filepath):
+    """
+    Read the raw -> corrected arrays from an error_correction_table.h.
+
+    applyCorrectedDistance() interpolates between the first two float arrays in
+    the header: raw sensor distances (ascending) and their corrected distances.
+
+    Returns:
+        (raw_distances, corrected_distances) as lists of floats
+    """
+    with open(filepath, 'r', encoding='utf-8') as f:
+        text = f.read()
+
+    arrays = re.findall(r'float\s+\w+\s*\[[^\]]*\]\s*=\s*\{([^}]*)\}', text)
+    if len(arrays) < 2:
+        raise ValueError(f"No raw/corrected float arrays found in {os.path.basename(filepath)}")
+
+    raw, corrected = [[float(v.strip().rstrip('fF')) for v in body.split(',') if v.strip()]
+                      for body in arrays[:2]]
+    if len(raw) != len(corrected) or len(raw) < 2:
+        raise ValueError("Error correction arrays must have the same length (at least 2)")
+    if any(b <= a for a, b in zip(raw, raw[1:])):
+        raise ValueError("Error correction raw distances must be strictly increasing")
+
+    return raw, corrected
 
 
 class LookupTable:
     """Lookup table class for distance correction"""
     
+    # Temperatures outside the sensor's operating range (C) are bad readings;
+    # they would stretch the temperature grid by one row per degree
+    GRID_TEMPERATURE_MIN = -40.0
+    GRID_TEMPERATURE_MAX = 125.0
+    
     def __init__(self, name="Untitled"):
         self.name = name
         self.positions = []  # Reference positions (e.g., string pot readings)
         self.distances = []  # Corresponding sensor distances
+        self.temperatures = []  # Sensor temperature per point (None if not logged)
         self.created_date = datetime.datetime.now().isoformat()
         self.source_files = []
         self.metadata = {}
+        self.inverse_distances = None  # Sorted distance -> position table for reverse lookups
+        self.inverse_positions = None
+        self._batch_corrector = None  # Built on first reverse_lookup_batch()
     
-    def add_data(self, positions, distances):
+    def add_data(self, positions, distances, temperatures=None):
         """Add data points to the lookup table"""
         self.positions.extend(positions)
         self.distances.extend(distances)
+        self.temperatures.extend(temperatures if temperatures is not None else [None] * len(positions))
     
-    def compile(self, bin_size=1.0, method='average'):
+    def compile(self, bin_size=1.0, method='average', temp_bin_size=None):
         """
         Compile the lookup table by binning and averaging data points.
         
         Args:
             bin_size: Size of position bins in mm
             method: 'average', 'median', or 'linear_fit'
+            temp_bin_size: Size of temperature bins in degrees C; also builds the
+                (position, temperature) grid when set and temperatures were logged
         """
         if not self.positions or not self.distances:
             return False
@@ -76,9 +118,109 @@ class LookupTable:
         self.metadata['bin_size'] = bin_size
         self.metadata['method'] = method
         self.metadata['compiled_date'] = datetime.datetime.now().isoformat()
+        self.build_inverse()
+        
+        self.grid_positions = self.grid_temperatures = self.grid_distances = None
+        if temp_bin_size:
+            self.compile_temperature_grid(bin_size, temp_bin_size, method)
+            self.metadata['temp_bin_size'] = temp_bin_size
+        
+        return True
+    
+    def compile_temperature_grid(self, bin_size, temp_bin_size, method='average'):
+        """
+        Bin the data by (position, temperature) onto a uniform 2D grid.
+        
+        Cells without data are filled by linear interpolation along position
+        within their temperature row; rows without data copy the nearest row.
+        The temperature axis always has at least two rows so the bilinear
+        evaluator never needs a special case.
+        
+        Returns:
+            True if a grid was built (needs logged temperatures and 2+ position bins)
+        """
+        samples = []
+        rejected = 0
+        for pos, dist, temp in zip(self.positions, self.distances, self.temperatures):
+            if temp is None:
+                continue
+            # Logs from before the host read temp as signed hold sub-zero
+            # readings as 65536 + t
+            temp = temp - 65536 if temp >= 32768 else temp
+            if not self.GRID_TEMPERATURE_MIN <= temp <= self.GRID_TEMPERATURE_MAX:
+                rejected += 1
+                continue
+            samples.append((pos, dist, temp))
+        if rejected:
+            print(f"Temperature grid: ignored {rejected} samples outside "
+                  f"{self.GRID_TEMPERATURE_MIN:.0f}..{self.GRID_TEMPERATURE_MAX:.0f} C")
+        if not samples:
+            return False
+        
+        cells = {}
+        for pos, dist, temp in samples:
+            key = (int(round(temp / temp_bin_size)), int(round(pos / bin_size)))
+            cells.setdefault(key, []).append(dist)
+        
+        temp_keys = [k[0] for k in cells]
+        pos_keys = [k[1] for k in cells]
+        t_lo, t_hi = min(temp_keys), max(max(temp_keys), min(temp_keys) + 1)
+        p_lo, p_hi = min(pos_keys), max(pos_keys)
+        if p_hi == p_lo:
+            return False
         
+        reduce = np.median if method == 'median' else np.mean
+        pos_axis = list(range(p_lo, p_hi + 1))
+        rows = {}
+        for t in range(t_lo, t_hi + 1):
+            filled = sorted(p for (row_t, p) in cells if row_t == t)
+            if filled:
+                values = [float(reduce(cells[(t, p)])) for p in filled]
+                rows[t] = [float(v) for v in np.interp(pos_axis, filled, values)]
+        
+        populated = sorted(rows)
+        self.grid_distances = []
+        for t in range(t_lo, t_hi + 1):
+            nearest = min(populated, key=lambda r: abs(r - t))
+            self.grid_distances.append(rows[nearest])
+        
+        self.grid_positions = [p * bin_size for p in pos_axis]
+        self.grid_temperatures = [t * temp_bin_size for t in range(t_lo, t_hi + 1)]
+        self.metadata['reference_temperature'] = float(np.mean([t for _, _, t in samples]))
         return True
     
+    def lookup_2d(self, position, temperature):
+        """
+        Bilinear lookup in the (position, temperature) grid, clamped at the edges.
+        Matches getNearestDistance2D() in the bilinear C header.
+        """
+        if not getattr(self, 'grid_distances', None):
+            return None
+        
+        def axis(value, values):
+            step = values[1] - values[0]
+            u = min(max((value - values[0]) / step, 0.0), len(values) - 1.0)
+            i = min(int(u), len(values) - 2)
+            return i, u - i
+        
+        i, fx = axis(position, self.grid_positions)
+        j, fy = axis(temperature, self.grid_temperatures)
+        lo, hi = self.grid_distances[j], self.grid_distances[j + 1]
+        d_lo = lo[i] + (lo[i + 1] - lo[i]) * fx
+        d_hi = hi[i] + (hi[i + 1] - hi[i]) * fx
+        return d_lo + (d_hi - d_lo) * fy
+    
+    def build_inverse(self):
+        """
+        Build the inverse (distance -> position) table used by reverse lookups.
+        
+        Distances are sorted and duplicates averaged, so the table stays
+        searchable when the sensor error is not monotonic.
+        """
+        self.inverse_distances, self.inverse_positions = inverse_table(self.compiled_distances,
+                                                                       self.compiled_positions)
+        self._batch_corrector = None
+    
     def lookup(self, position):
         """
         Look up the corrected distance for a given position using linear interpolation.
@@ -105,7 +247,204 @@ class LookupTable:
                 return y1 + (y2 - y1) * (position - x1) / (x2 - x1)
         
         return None
-    
+
+    def resample_uniform(self, step=None):
+        """
+        Resample the compiled table onto an exact uniform position grid.
+
+        Args:
+            step: Grid spacing in mm (defaults to the compile bin size)
+
+        Returns:
+            (origin, step, values, slopes) where values[k] is the distance at
+            origin + k * step and slopes[k] = values[k + 1] - values[k] per grid
+            cell (the last slope is 0 so the top of the range needs no clamp).
+            Returns None if the table is not compiled.
+        """
+        if not hasattr(self, 'compiled_positions') or len(self.compiled_positions) < 2:
+            return None
+
+        if step is None:
+            step = float(self.metadata.get('bin_size', 1.0))
+
+        origin = float(self.compiled_positions[0])
+        span = float(self.compiled_positions[-1]) - origin
+        count = int(round(span / step)) + 1
+
+        grid = origin + np.arange(count) * step
+        values = np.interp(grid, self.compiled_positions, self.compiled_distances)
+        slopes = np.append(np.diff(values), 0.0)
+
+        return origin, step, values.tolist(), slopes.tolist()
+
+    def fixed_point_table(self):
+        """
+        Build the integer variant of the uniform-grid table for the MCU.
+
+        Inputs and outputs are in 0.1 mm (the CAN 0x13 distance unit). Values and
+        per-cell slopes are stored in 1/256 of 0.1 mm and the grid index comes
+        from a Q32 reciprocal of the step, so the evaluator needs no divide.
+
+        Both paths truncate their output to 0.1 mm; the fixed path rounds its
+        input to the nearest 0.1 mm.
+
+        Returns:
+            dict with the table constants and 'max_error_lsb', the worst
+            deviation from the float path over inputs every 0.01 mm in range
+            (and one bin either side). Returns None if the table is not compiled.
+        """
+        resampled = self.resample_uniform()
+        if resampled is None:
+            return None
+        origin, step, values, _ = resampled
+
+        values_q8 = [int(round(v * 2560)) for v in values]
+        table = {
+            'origin_q': int(round(origin * 10)),
+            'inv_step_q32': int(round(2 ** 32 / (step * 10))),
+            'values_q8': values_q8,
+            'slopes_q8': [values_q8[i + 1] - values_q8[i] for i in range(len(values_q8) - 1)] + [0],
+        }
+
+        # Compare against the float interpolation truncated to 0.1 mm, as done by
+        # correct_selected_distance(), for inputs between the 0.1 mm steps too:
+        # every input in [q - 0.05, q + 0.05) mm rounds to position_q = q
+        end_q = int(round((origin + step * (len(values) - 1)) * 10))
+        inputs = np.arange(max(table['origin_q'] - 10, 0), end_q + 11)
+        fixed = np.array([self.evaluate_fixed_point(table, int(q)) for q in inputs])
+        table['max_error_lsb'] = 0
+        for sub_step in range(10):
+            positions_mm = (inputs + (sub_step - 4.5) / 10.0) / 10.0
+            reference = np.floor(np.interp(positions_mm, self.compiled_positions, self.compiled_distances) * 10)
+            table['max_error_lsb'] = max(table['max_error_lsb'], int(np.max(np.abs(fixed - reference))))
+
+        return table
+
+    @staticmethod
+    def evaluate_fixed_point(table, position_q):
+        """Bit-exact Python model of the generated getNearestDistanceQ()"""
+        offset = max(position_q - table['origin_q'], 0)
+        u = min(offset * table['inv_step_q32'], (len(table['values_q8']) - 1) << 32)
+        i = u >> 32
+        y = table['values_q8'][i] + ((table['slopes_q8'][i] * ((u >> 16) & 0xFFFF)) >> 16)
+        return (y >> 8) if y > 0 else 0
+
+    def compress(self, max_error):
+        """
+        Reduce the compiled bins to piecewise-linear knots.
+
+        Knots are a subset of the bins, chosen greedily so every bin lies within
+        max_error mm of the line through the surrounding knots. Both tables are
+        linear between bins, so the bound holds across the whole range.
+
+        Args:
+            max_error: Allowed deviation from the compiled bins in mm
+
+        Returns:
+            (knot_positions, knot_distances, worst_error) or None if not compiled
+        """
+        if not hasattr(self, 'compiled_positions') or len(self.compiled_positions) < 2:
+            return None
+
+        return self.reduce_knots(self.compiled_positions, self.compiled_distances, max_error)
+
+    def fuse(self, error_raw, error_corrected, max_error, step=0.1):
+        """
+        Compose the error correction table and this table into one transfer function.
+
+        Reproduces apply_distance_correction() in the firmware: the raw distance goes
+        through the error correction table, then through this table, and the lookup
+        result wins when the two differ by more than 2 mm. The composition is sampled
+        every step mm across the error table range (it is constant outside, as both
+        tables clamp) and reduced to knots like compress().
+
+        Args:
+            error_raw: Raw distances of the error correction table (mm, ascending)
+            error_corrected: Corrected distances for error_raw (mm)
+            max_error: Allowed deviation from the sampled composition in mm
+            step: Sample spacing in mm
+
+        Returns:
+            (knot_inputs, knot_outputs, worst_error) or None if not compiled
+        """
+        if not hasattr(self, 'compiled_positions') or len(self.compiled_positions) < 2:
+            return None
+        if len(error_raw) < 2:
+            return None
+
+        def compose(raw):
+            """Return (lookup_wins, output) for one raw distance"""
+            corrected = float(np.interp(raw, error_raw, error_corrected))
+            lookup = float(np.interp(corrected, self.compiled_positions, self.compiled_distances))
+            # Same 2mm arbitration as the firmware
+            lookup_wins = lookup > 0 and abs(lookup - corrected) > 2.0
+            return lookup_wins, (lookup if lookup_wins else corrected)
+
+        count = int((error_raw[-1] - error_raw[0]) / step) + 1
+        grid = sorted(set(round(x, 4) for x in
+                          [error_raw[0] + i * step for i in range(count)] + list(error_raw)))
+
+        # The arbitration makes the composition jump; bisect each jump down to
+        # 1 micron and put a knot on both sides so it stays a step, not a ramp
+        inputs = []
+        for a, b in zip(grid, grid[1:]):
+            inputs.append(a)
+            if compose(a)[0] != compose(b)[0]:
+                lo, hi = a, b
+                while hi - lo > 1e-3:
+                    mid = (lo + hi) / 2
+                    if compose(mid)[0] == compose(a)[0]:
+                        lo = mid
+                    else:
+                        hi = mid
+                inputs.extend(x for x in (round(lo, 4), round(hi, 4)) if a < x < b)
+        inputs.append(grid[-1])
+        inputs = sorted(set(inputs))
+        outputs = [compose(x)[1] for x in inputs]
+
+        return self.reduce_knots(inputs, outputs, max_error)
+
+    @staticmethod
+    def reduce_knots(xs, ys, max_error):
+        """Greedy piecewise-linear knot reduction shared by compress() and fuse()"""
+        knots = [0]
+        anchor = 0
+
+        while anchor < len(xs) - 1:
+            # Slopes from the anchor that stay within max_error of every bin so far
+            slope_lo, slope_hi = -float('inf'), float('inf')
+            end = anchor + 1
+            while end < len(xs):
+                dx = xs[end] - xs[anchor]
+                slope = (ys[end] - ys[anchor]) / dx
+                if not (slope_lo <= slope <= slope_hi):
+                    break
+                slope_lo = max(slope_lo, (ys[end] - max_error - ys[anchor]) / dx)
+                slope_hi = min(slope_hi, (ys[end] + max_error - ys[anchor]) / dx)
+                end += 1
+            anchor = max(end - 1, anchor + 1)
+            knots.append(anchor)
+
+        # Round like the header does, then measure against every bin. Rounding
+        # can push a bin just past max_error: add a knot on the worst bin until
+        # the bound holds
+        while True:
+            knot_positions = [round(xs[i], 4) for i in knots]
+            knot_distances = [round(ys[i], 4) for i in knots]
+            rebuilt = np.interp(xs, knot_positions, knot_distances)
+            errors = [abs(rebuilt[i] - ys[i]) for i in range(len(xs))]
+            worst = max(range(len(xs)), key=errors.__getitem__)
+            if errors[worst] <= max_error or worst in knots:
+                break
+            bisect.insort(knots, worst)
+
+        worst_error = errors[worst]
+        if worst_error > max_error:
+            raise ValueError(f"Cannot meet {max_error}mm with knots rounded to 0.0001mm "
+                             f"(worst {worst_error:.5f}mm)")
+
+        return knot_positions, knot_distances, worst_error
+
     def reverse_lookup(self, distance):
         """
         Reverse lookup: get position for a given distance.
@@ -113,28 +452,35 @@ class LookupTable:
         if not hasattr(self, 'compiled_positions') or not self.compiled_positions:
             return None
         
-        positions = self.compiled_positions
-        distances = self.compiled_distances
+        distances = self.inverse_distances
+        positions = self.inverse_positions
         
-        # Handle edge cases
-        if distance <= min(distances):
-            idx = distances.index(min(distances))
-            return positions[idx]
-        if distance >= max(distances):
-            idx = distances.index(max(distances))
-            return positions[idx]
-        
-        # Find interpolation points (assuming monotonic relationship)
-        for i in range(len(distances) - 1):
-            d1, d2 = distances[i], distances[i + 1]
-            if (d1 <= distance <= d2) or (d2 <= distance <= d1):
-                p1, p2 = positions[i], positions[i + 1]
-                
-                # Linear interpolation
-                if d2 != d1:
-                    return p1 + (p2 - p1) * (distance - d1) / (d2 - d1)
+        # Handle edge cases (inverse table is sorted, so the extrema are the ends)
+        if distance <= distances[0]:
+            return positions[0]
+        if distance >= distances[-1]:
+            return positions[-1]
         
-        return None
+        # Binary search for the bracketing pair (distances are strictly increasing)
+        i = bisect.bisect_right(distances, distance) - 1
+        d1, d2 = distances[i], distances[i + 1]
+        p1, p2 = positions[i], positions[i + 1]
+        
+        # Linear interpolation
+        return p1 + (p2 - p1) * (distance - d1) / (d2 - d1)
+    
+    def reverse_lookup_batch(self, distances):
+        """
+        Reverse lookup for a whole array of sensor distances in one native call.
+        Returns a numpy array of positions, or None if the table is not compiled.
+        """
+        if not hasattr(self, 'compiled_positions') or not self.compiled_positions:
+            return None
+        
+        if self._batch_corrector is None:
+            self._batch_corrector = BatchCorrector(self.inverse_distances, self.inverse_positions)
+        
+        return self._batch_corrector.correct(distances)
     
     def get_correction(self, sensor_distance):
         """
@@ -155,6 +501,7 @@ class LookupTable:
             'metadata': self.metadata,
             'raw_positions': self.positions,
             'raw_distances': self.distances,
+            'raw_temperatures': self.temperatures,
         }
         
         if hasattr(self, 'compiled_positions'):
@@ -163,6 +510,11 @@ class LookupTable:
             data['compiled_std'] = self.compiled_std
             data['compiled_count'] = self.compiled_count
         
+        if getattr(self, 'grid_distances', None):
+            data['grid_positions'] = self.grid_positions
+            data['grid_temperatures'] = self.grid_temperatures
+            data['grid_distances'] = self.grid_distances
+        
         return data
     
     @classmethod
@@ -174,12 +526,19 @@ class LookupTable:
         lut.metadata = data.get('metadata', {})
         lut.positions = data.get('raw_positions', [])
         lut.distances = data.get('raw_distances', [])
+        lut.temperatures = data.get('raw_temperatures', [None] * len(lut.positions))
         
         if 'compiled_positions' in data:
             lut.compiled_positions = data['compiled_positions']
             lut.compiled_distances = data['compiled_distances']
             lut.compiled_std = data.get('compiled_std', [])
             lut.compiled_count = data.get('compiled_count', [])
+            lut.build_inverse()
+        
+        if 'grid_distances' in data:
+            lut.grid_positions = data['grid_positions']
+            lut.grid_temperatures = data['grid_temperatures']
+            lut.grid_distances = data['grid_distances']
         
         return lut
     
@@ -208,7 +567,7 @@ class LookupTableGUI:
         self.lookup_tables = {}  # name -> LookupTable
         self.current_lut = None
         self.loaded_files = []
-        self.pending_data = {'positions': [], 'distances': [], 'files': []}
+        self.pending_data = {'positions': [], 'distances': [], 'temperatures': [], 'files': []}
         
         # Default data directory
         self.data_dir = os.path.join(os.path.dirname(__file__), "data")
@@ -373,6 +732,9 @@ class LookupTableGUI:
         ttk.Label(bin_frame, text="Bin Size (mm):").pack(side=tk.LEFT)
         self.bin_size_var = tk.StringVar(value="1.0")
         ttk.Entry(bin_frame, textvariable=self.bin_size_var, width=10).pack(side=tk.LEFT, padx=5)
+        ttk.Label(bin_frame, text="Temp Bin (°C):").pack(side=tk.LEFT, padx=(10, 0))
+        self.temp_bin_size_var = tk.StringVar(value="5.0")
+        ttk.Entry(bin_frame, textvariable=self.temp_bin_size_var, width=8).pack(side=tk.LEFT, padx=5)
         
         # Method
         method_frame = ttk.Frame(options_frame)
@@ -382,6 +744,17 @@ class LookupTableGUI:
         ttk.Combobox(method_frame, textvariable=self.method_var, 
                      values=["average", "median"], state="readonly", width=15).pack(side=tk.LEFT, padx=5)
         
+        # C header layout
+        layout_frame = ttk.Frame(options_frame)
+        layout_frame.pack(fill=tk.X, padx=5, pady=2)
+        ttk.Label(layout_frame, text="C Header Layout:").pack(side=tk.LEFT)
+        self.header_layout_var = tk.StringVar(value="search")
+        ttk.Combobox(layout_frame, textvariable=self.header_layout_var,
+                     values=["search", "uniform", "fixed", "cpp", "compressed", "fused", "bilinear"], state="readonly", width=15).pack(side=tk.LEFT, padx=5)
+        ttk.Label(layout_frame, text="Max Error (mm):").pack(side=tk.LEFT, padx=(10, 0))
+        self.max_error_var = tk.StringVar(value="0.1")
+        ttk.Entry(layout_frame, textvariable=self.max_error_var, width=8).pack(side=tk.LEFT, padx=5)
+        
         # LUT name
         name_frame = ttk.Frame(options_frame)
         name_frame.pack(fill=tk.X, padx=5, pady=2)
@@ -596,11 +969,13 @@ class LookupTableGUI:
                     try:
                         # Excel format: distance, temp, position, delta, ...
                         distance = float(row[0]) if row[0] is not None else None
+                        temp = float(row[1]) if row[1] is not None else None
                         position = float(row[2]) if row[2] is not None else None
                         
                         if distance is not None and position is not None:
                             self.pending_data['positions'].append(position)
                             self.pending_data['distances'].append(distance)
+                            self.pending_data['temperatures'].append(temp)
                             row_count += 1
                     except (ValueError, TypeError):
                         continue
@@ -617,7 +992,7 @@ class LookupTableGUI:
     
     def clear_pending_data(self):
         """Clear all pending data"""
-        self.pending_data = {'positions': [], 'distances': [], 'files': []}
+        self.pending_data = {'positions': [], 'distances': [], 'temperatures': [], 'files': []}
         self.update_pending_display()
     
     def update_pending_display(self):
@@ -668,18 +1043,25 @@ class LookupTableGUI:
             messagebox.showerror("Error", "Invalid bin size")
             return
         
+        try:
+            temp_bin_size = float(self.temp_bin_size_var.get()) if self.temp_bin_size_var.get().strip() else None
+        except ValueError:
+            messagebox.showerror("Error", "Invalid temperature bin size")
+            return
+        
         name = self.lut_name_var.get().strip()
         if not name:
             name = f"LUT_{datetime.datetime.now().strftime('%Y%m%d_%H%M%S')}"
         
         # Create new lookup table
         lut = LookupTable(name)
-        lut.add_data(self.pending_data['positions'], self.pending_data['distances'])
+        lut.add_data(self.pending_data['positions'], self.pending_data['distances'],
+                     self.pending_data['temperatures'])
         lut.source_files = self.pending_data['files'].copy()
         
         # Compile
         method = self.method_var.get()
-        if lut.compile(bin_size=bin_size, method=method):
+        if lut.compile(bin_size=bin_size, method=method, temp_bin_size=temp_bin_size):
             self.lookup_tables[name] = lut
             self.current_lut = lut
             self.update_lut_list()
@@ -890,10 +1272,16 @@ class LookupTableGUI:
             f.write('    print(f"True position: {true_position:.2f}mm")\n')
             f.write('"""\n\n')
             
+            f.write('import bisect\n\n')
+            
             f.write('# Lookup table data\n')
             f.write(f"LUT_POSITIONS = {lut.compiled_positions}\n\n")
             f.write(f"LUT_DISTANCES = {lut.compiled_distances}\n\n")
             
+            f.write('# Inverse table: distances sorted and de-duplicated for reverse lookup\n')
+            f.write(f"LUT_INVERSE_DISTANCES = {lut.inverse_distances}\n\n")
+            f.write(f"LUT_INVERSE_POSITIONS = {lut.inverse_positions}\n\n")
+            
             f.write('def get_true_position(sensor_distance):\n')
             f.write('    """\n')
             f.write('    Get the true position for a given sensor distance reading.\n')
@@ -904,26 +1292,20 @@ class LookupTableGUI:
             f.write('    Returns:\n')
             f.write('        True position (mm) or None if out of range\n')
             f.write('    """\n')
-            f.write('    positions = LUT_POSITIONS\n')
-            f.write('    distances = LUT_DISTANCES\n')
+            f.write('    positions = LUT_INVERSE_POSITIONS\n')
+            f.write('    distances = LUT_INVERSE_DISTANCES\n')
             f.write('    \n')
             f.write('    # Handle edge cases\n')
-            f.write('    if sensor_distance <= min(distances):\n')
-            f.write('        idx = distances.index(min(distances))\n')
-            f.write('        return positions[idx]\n')
-            f.write('    if sensor_distance >= max(distances):\n')
-            f.write('        idx = distances.index(max(distances))\n')
-            f.write('        return positions[idx]\n')
+            f.write('    if sensor_distance <= distances[0]:\n')
+            f.write('        return positions[0]\n')
+            f.write('    if sensor_distance >= distances[-1]:\n')
+            f.write('        return positions[-1]\n')
             f.write('    \n')
             f.write('    # Linear interpolation\n')
-            f.write('    for i in range(len(distances) - 1):\n')
-            f.write('        d1, d2 = distances[i], distances[i + 1]\n')
-            f.write('        if (d1 <= sensor_distance <= d2) or (d2 <= sensor_distance <= d1):\n')
-            f.write('            p1, p2 = positions[i], positions[i + 1]\n')
-            f.write('            if d2 != d1:\n')
-            f.write('                return p1 + (p2 - p1) * (sensor_distance - d1) / (d2 - d1)\n')
-            f.write('    \n')
-            f.write('    return None\n\n')
+            f.write('    i = bisect.bisect_right(distances, sensor_distance) - 1\n')
+            f.write('    d1, d2 = distances[i], distances[i + 1]\n')
+            f.write('    p1, p2 = positions[i], positions[i + 1]\n')
+            f.write('    return p1 + (p2 - p1) * (sensor_distance - d1) / (d2 - d1)\n\n')
             
             f.write('def get_sensor_error(sensor_distance):\n')
             f.write('    """\n')
@@ -955,10 +1337,37 @@ class LookupTableGUI:
             f.write('            error = get_sensor_error(dist)\n')
             f.write('            print(f"Sensor: {dist:6.2f}mm → True: {true_pos:6.2f}mm | Error: {error:+6.2f}mm")\n')
     
-    def write_c_header(self, filepath, lut=None):
+    def write_c_header(self, filepath, lut=None, layout=None):
         """Write lookup table to C header file"""
         if lut is None:
             lut = self.current_lut
+        if layout is None:
+            layout = self.header_layout_var.get()
+        
+        if layout == 'uniform':
+            self.write_uniform_c_header(filepath, lut)
+            return
+        if layout == 'fixed':
+            self.write_fixed_point_c_header(filepath, lut)
+            return
+        if layout == 'cpp':
+            self.write_cpp_header(filepath, lut)
+            return
+        if layout == 'compressed':
+            self.write_compressed_c_header(filepath, lut, float(self.max_error_var.get()))
+            return
+        if layout == 'bilinear':
+            self.write_bilinear_c_header(filepath, lut)
+            return
+        if layout == 'fused':
+            error_path = filedialog.askopenfilename(
+                title="Select error_correction_table.h to fuse",
+                filetypes=[("C Header files", "*.h"), ("All files", "*.*")]
+            )
+            if not error_path:
+                raise ValueError("Fused layout needs an error_correction_table.h")
+            self.write_fused_c_header(filepath, lut, error_path, float(self.max_error_var.get()))
+            return
         
         with open(filepath, 'w', encoding='utf-8') as f:
             f.write(f"// Sensor Distance Lookup Table: {lut.name}\n")
@@ -986,6 +1395,446 @@ class LookupTableGUI:
             
             f.write(f"#endif // {guard}\n")
     
+    def write_uniform_c_header(self, filepath, lut):
+        """Write lookup table resampled onto a uniform grid (O(1) direct-index lookup)"""
+        resampled = lut.resample_uniform()
+        if resampled is None:
+            raise ValueError("Uniform layout needs a compiled table with at least 2 entries")
+        origin, step, values, slopes = resampled
+        
+        with open(filepath, 'w', encoding='utf-8') as f:
+            f.write(f"// Sensor Distance Lookup Table: {lut.name}\n")
+            f.write(f"// Generated: {datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S')}\n")
+            f.write(f"// Bin Size: {lut.metadata.get('bin_size', 'N/A')} mm\n")
+            f.write(f"// Method: {lut.metadata.get('method', 'N/A')}\n")
+            f.write(f"// Layout: uniform grid, {len(values)} points every {step} mm from {origin:.4f} mm\n\n")
+            
+            guard = lut.name.upper().replace(' ', '_') + "_H"
+            f.write(f"#ifndef {guard}\n")
+            f.write(f"#define {guard}\n\n")
+            
+            f.write(f"#define LOOKUP_TABLE_SIZE {len(values)}\n")
+            f.write("#define LOOKUP_TABLE_UNIFORM 1\n")
+            f.write(f"#define LOOKUP_TABLE_ORIGIN {origin:.6f}f\n")
+            f.write(f"#define LOOKUP_TABLE_INV_STEP {1.0 / step:.9e}f\n\n")
+            
+            f.write("// Distance at LOOKUP_TABLE_ORIGIN + k * step (mm)\n")
+            f.write("static const float lut_values[LOOKUP_TABLE_SIZE] = {\n")
+            for i, value in enumerate(values):
+                comma = "," if i < len(values) - 1 else ""
+                f.write(f"    {value:.4f}f{comma}\n")
+            f.write("};\n\n")
+            
+            f.write("// Distance change across each grid cell (mm), last entry is 0\n")
+            f.write("static const float lut_slopes[LOOKUP_TABLE_SIZE] = {\n")
+            for i, slope in enumerate(slopes):
+                comma = "," if i < len(slopes) - 1 else ""
+                f.write(f"    {slope:.6f}f{comma}\n")
+            f.write("};\n\n")
+            
+            f.write("// Function to get nearest distance for a position (interpolated)\n")
+            f.write("// Direct index into the uniform grid: no search and no division.\n")
+            f.write("static inline float getNearestDistance(float position) {\n")
+            f.write("    float u = (position - LOOKUP_TABLE_ORIGIN) * LOOKUP_TABLE_INV_STEP;\n")
+            f.write("    u = (u < 0.0f) ? 0.0f : u;\n")
+            f.write("    u = (u > (float)(LOOKUP_TABLE_SIZE - 1)) ? (float)(LOOKUP_TABLE_SIZE - 1) : u;\n")
+            f.write("    \n")
+            f.write("    int i = (int)u;\n")
+            f.write("    return lut_values[i] + lut_slopes[i] * (u - (float)i);\n")
+            f.write("}\n\n")
+            
+            f.write(f"#endif // {guard}\n")
+    
+    def write_bilinear_c_header(self, filepath, lut):
+        """Write the (position, temperature) grid with an O(1) bilinear evaluator"""
+        if not getattr(lut, 'grid_distances', None):
+            raise ValueError("Bilinear layout needs a table compiled from data with temperatures "
+                             "and a temperature bin size")
+        
+        positions = lut.grid_positions
+        temperatures = lut.grid_temperatures
+        pos_step = positions[1] - positions[0]
+        temp_step = temperatures[1] - temperatures[0]
+        reference = lut.metadata.get('reference_temperature', temperatures[0])
+        
+        with open(filepath, 'w', encoding='utf-8') as f:
+            f.write(f"// Sensor Distance Lookup Table: {lut.name}\n")
+            f.write(f"// Generated: {datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S')}\n")
+            f.write(f"// Bin Size: {lut.metadata.get('bin_size', 'N/A')} mm\n")
+            f.write(f"// Method: {lut.metadata.get('method', 'N/A')}\n")
+            f.write(f"// Layout: bilinear, {len(positions)} positions every {pos_step} mm x "
+                    f"{len(temperatures)} temperatures every {temp_step} C\n\n")
+            
+            guard = lut.name.upper().replace(' ', '_') + "_H"
+            f.write(f"#ifndef {guard}\n")
+            f.write(f"#define {guard}\n\n")
+            
+            f.write(f"#define LOOKUP_TABLE_SIZE {len(positions)}\n")
+            f.write("#define LOOKUP_TABLE_2D 1\n")
+            f.write(f"#define LOOKUP_TABLE_TEMP_COUNT {len(temperatures)}\n")
+            f.write(f"#define LOOKUP_TABLE_ORIGIN {positions[0]:.6f}f\n")
+            f.write(f"#define LOOKUP_TABLE_INV_STEP {1.0 / pos_step:.9e}f\n")
+            f.write(f"#define LOOKUP_TABLE_TEMP_ORIGIN {temperatures[0]:.6f}f\n")
+            f.write(f"#define LOOKUP_TABLE_TEMP_INV_STEP {1.0 / temp_step:.9e}f\n")
+            f.write("// Mean logged temperature, used when no temperature is available\n")
+            f.write(f"#define LOOKUP_TABLE_TEMP_REFERENCE {reference:.2f}f\n\n")
+            
+            f.write("// Distance (mm) at [temperature row][position column]\n")
+            f.write("static const float lut_grid[LOOKUP_TABLE_TEMP_COUNT][LOOKUP_TABLE_SIZE] = {\n")
+            for j, row in enumerate(lut.grid_distances):
+                comma = "," if j < len(lut.grid_distances) - 1 else ""
+                f.write(f"    {{ // {temperatures[j]:.1f} C\n")
+                for i in range(0, len(row), 8):
+                    chunk = ", ".join(f"{v:.4f}f" for v in row[i:i + 8])
+                    tail = "," if i + 8 < len(row) else ""
+                    f.write(f"        {chunk}{tail}\n")
+                f.write(f"    }}{comma}\n")
+            f.write("};\n\n")
+            
+            f.write("// Function to get nearest distance for a position at a temperature (bilinear)\n")
+            f.write("// Direct index on both uniform axes: no search and no division.\n")
+            f.write("static inline float getNearestDistance2D(float position, float temperature) {\n")
+            f.write("    float u = (position - LOOKUP_TABLE_ORIGIN) * LOOKUP_TABLE_INV_STEP;\n")
+            f.write("    u = (u < 0.0f) ? 0.0f : u;\n")
+            f.write("    u = (u > (float)(LOOKUP_TABLE_SIZE - 1)) ? (float)(LOOKUP_TABLE_SIZE - 1) : u;\n")
+            f.write("    float v = (temperature - LOOKUP_TABLE_TEMP_ORIGIN) * LOOKUP_TABLE_TEMP_INV_STEP;\n")
+            f.write("    v = (v < 0.0f) ? 0.0f : v;\n")
+            f.write("    v = (v > (float)(LOOKUP_TABLE_TEMP_COUNT - 1)) ? (float)(LOOKUP_TABLE_TEMP_COUNT - 1) : v;\n")
+            f.write("    \n")
+            f.write("    int i = (int)u;\n")
+            f.write("    int j = (int)v;\n")
+            f.write("    i = (i > LOOKUP_TABLE_SIZE - 2) ? LOOKUP_TABLE_SIZE - 2 : i;\n")
+            f.write("    j = (j > LOOKUP_TABLE_TEMP_COUNT - 2) ? LOOKUP_TABLE_TEMP_COUNT - 2 : j;\n")
+            f.write("    float fx = u - (float)i;\n")
+            f.write("    float fy = v - (float)j;\n")
+            f.write("    \n")
+            f.write("    const float *lo = lut_grid[j];\n")
+            f.write("    const float *hi = lut_grid[j + 1];\n")
+            f.write("    float d_lo = lo[i] + (lo[i + 1] - lo[i]) * fx;\n")
+            f.write("    float d_hi = hi[i] + (hi[i + 1] - hi[i]) * fx;\n")
+            f.write("    return d_lo + (d_hi - d_lo) * fy;\n")
+            f.write("}\n\n")
+            
+            f.write("// Function to get nearest distance for a position (interpolated, reference temperature)\n")
+            f.write("static inline float getNearestDistance(float position) {\n")
+            f.write("    return getNearestDistance2D(position, LOOKUP_TABLE_TEMP_REFERENCE);\n")
+            f.write("}\n\n")
+            
+            f.write(f"#endif // {guard}\n")
+    
+    def write_fixed_point_c_header(self, filepath, lut):
+        """Write the integer (0.1 mm) uniform-grid lookup table for the MCU correction path"""
+        table = lut.fixed_point_table()
+        if table is None:
+            raise ValueError("Fixed-point layout needs a compiled table with at least 2 entries")
+        if table['max_error_lsb'] > 1:
+            raise ValueError(f"Fixed-point table deviates {table['max_error_lsb']} LSB from the float path "
+                             f"(limit 1 LSB), use a smaller bin size or the float layout")
+        
+        size = len(table['values_q8'])
+        
+        with open(filepath, 'w', encoding='utf-8') as f:
+            f.write(f"// Sensor Distance Lookup Table: {lut.name}\n")
+            f.write(f"// Generated: {datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S')}\n")
+            f.write(f"// Bin Size: {lut.metadata.get('bin_size', 'N/A')} mm\n")
+            f.write(f"// Method: {lut.metadata.get('method', 'N/A')}\n")
+            f.write("// Layout: fixed-point uniform grid, input/output in 0.1 mm\n")
+            f.write(f"// Max deviation from float path: {table['max_error_lsb']} LSB\n\n")
+            
+            guard = lut.name.upper().replace(' ', '_') + "_H"
+            f.write(f"#ifndef {guard}\n")
+            f.write(f"#define {guard}\n\n")
+            
+            f.write("#include <stdint.h>\n\n")
+            
+            f.write(f"#define LOOKUP_TABLE_SIZE {size}\n")
+            f.write("#define LOOKUP_TABLE_FIXED_POINT 1\n")
+            f.write(f"#define LOOKUP_TABLE_ORIGIN_Q {table['origin_q']}u      // 0.1 mm\n")
+            f.write(f"#define LOOKUP_TABLE_INV_STEP_Q32 {table['inv_step_q32']}u // 2^32 / step (step in 0.1 mm)\n")
+            f.write(f"#define LOOKUP_TABLE_U_MAX {(size - 1) << 32}ull\n\n")
+            
+            f.write("// Distance at each grid point (1/256 of 0.1 mm)\n")
+            f.write("static const int32_t lut_values_q8[LOOKUP_TABLE_SIZE] = {\n")
+            for i, value in enumerate(table['values_q8']):
+                comma = "," if i < size - 1 else ""
+                f.write(f"    {value}{comma}\n")
+            f.write("};\n\n")
+            
+            f.write("// Distance change across each grid cell (1/256 of 0.1 mm), last entry is 0\n")
+            f.write("static const int32_t lut_slopes_q8[LOOKUP_TABLE_SIZE] = {\n")
+            for i, slope in enumerate(table['slopes_q8']):
+                comma = "," if i < size - 1 else ""
+                f.write(f"    {slope}{comma}\n")
+            f.write("};\n\n")
+            
+            f.write("// Function to get nearest distance for a position (interpolated, 0.1 mm units)\n")
+            f.write("// Integer only: the step reciprocal is precomputed, so there is no divide.\n")
+            f.write("static inline uint32_t getNearestDistanceQ(uint32_t position_q) {\n")
+            f.write("    uint32_t offset = (position_q > LOOKUP_TABLE_ORIGIN_Q) ? position_q - LOOKUP_TABLE_ORIGIN_Q : 0u;\n")
+            f.write("    uint64_t u = (uint64_t)offset * LOOKUP_TABLE_INV_STEP_Q32;\n")
+            f.write("    u = (u > LOOKUP_TABLE_U_MAX) ? LOOKUP_TABLE_U_MAX : u;\n")
+            f.write("    \n")
+            f.write("    uint32_t i = (uint32_t)(u >> 32);\n")
+            f.write("    int32_t frac = (int32_t)((u >> 16) & 0xFFFFu);\n")
+            f.write("    int32_t y = lut_values_q8[i] + (int32_t)(((int64_t)lut_slopes_q8[i] * frac) >> 16);\n")
+            f.write("    return (y > 0) ? ((uint32_t)y >> 8) : 0u; // Truncated to 0.1 mm, like the float path\n")
+            f.write("}\n\n")
+            
+            f.write("// Float wrapper (mm) so the header stays a drop-in for float callers\n")
+            f.write("static inline float getNearestDistance(float position) {\n")
+            f.write("    uint32_t position_q = (position > 0.0f) ? (uint32_t)(position * 10.0f + 0.5f) : 0u;\n")
+            f.write("    return getNearestDistanceQ(position_q) * 0.1f;\n")
+            f.write("}\n\n")
+            
+            f.write(f"#endif // {guard}\n")
+    
+    def write_cpp_header(self, filepath, lut):
+        """Write lookup table as a constexpr LookupTable<N, Layout> instance (lookup_table_template.hpp)"""
+        positions = lut.compiled_positions
+        distances = lut.compiled_distances
+        if len(positions) < 2:
+            raise ValueError("C++ layout needs a compiled table with at least 2 entries")
+        
+        # Evenly spaced bins can be indexed directly, otherwise fall back to search
+        steps = np.diff(positions)
+        uniform = bool(max(abs(steps - steps[0])) < 1e-4)
+        layout = "LutLayout::Uniform" if uniform else "LutLayout::Search"
+        
+        # Compiled bins carry the sensor error, which is often not monotonic,
+        # so reverse lookups get their own sorted table
+        monotonic = all(b >= a for a, b in zip(distances, distances[1:]))
+        inverse_distances, inverse_positions = inverse_table(distances, positions, decimals=6)
+        if len(inverse_distances) < 2:
+            raise ValueError("C++ layout needs at least 2 distinct distances for the inverse table")
+        
+        with open(filepath, 'w', encoding='utf-8') as f:
+            f.write(f"// Sensor Distance Lookup Table: {lut.name}\n")
+            f.write(f"// Generated: {datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S')}\n")
+            f.write(f"// Bin Size: {lut.metadata.get('bin_size', 'N/A')} mm\n")
+            f.write(f"// Method: {lut.metadata.get('method', 'N/A')}\n")
+            f.write(f"// Layout: constexpr C++ LookupTable<{len(positions)}, {layout}>\n\n")
+            
+            guard = lut.name.upper().replace(' ', '_') + "_HPP"
+            f.write(f"#ifndef {guard}\n")
+            f.write(f"#define {guard}\n\n")
+            
+            f.write('#include "lookup_table_template.hpp"\n\n')
+            
+            f.write(f"#define LOOKUP_TABLE_SIZE {len(positions)}\n\n")
+            
+            f.write(f"constexpr LookupTable<LOOKUP_TABLE_SIZE, {layout}> kLookupTable = {{\n")
+            f.write("    { // Position array (mm)\n")
+            for i, pos in enumerate(positions):
+                comma = "," if i < len(positions) - 1 else ""
+                f.write(f"        {pos:.6f}f{comma}\n")
+            f.write("    },\n")
+            f.write("    { // Distance array (mm)\n")
+            for i, dist in enumerate(distances):
+                comma = "," if i < len(distances) - 1 else ""
+                f.write(f"        {dist:.6f}f{comma}\n")
+            f.write("    }\n")
+            f.write("};\n\n")
+            
+            f.write(f"#define INVERSE_TABLE_SIZE {len(inverse_distances)}\n")
+            f.write(f"#define INVERSE_DISTANCE_MIN {inverse_distances[0]:.6f}f\n")
+            f.write(f"#define INVERSE_DISTANCE_MAX {inverse_distances[-1]:.6f}f\n\n")
+            
+            f.write("constexpr InverseLookupTable<INVERSE_TABLE_SIZE> kInverseTable = {{\n")
+            f.write("    { // Inverse distance array (mm), strictly increasing\n")
+            for i, dist in enumerate(inverse_distances):
+                comma = "," if i < len(inverse_distances) - 1 else ""
+                f.write(f"        {dist:.6f}f{comma}\n")
+            f.write("    },\n")
+            f.write("    { // Inverse position array (mm)\n")
+            for i, pos in enumerate(inverse_positions):
+                comma = "," if i < len(inverse_positions) - 1 else ""
+                f.write(f"        {pos:.6f}f{comma}\n")
+            f.write("    }\n")
+            f.write("}};\n\n")
+            
+            f.write('static_assert(kLookupTable.isSorted(), "Lookup table positions must be strictly increasing");\n')
+            f.write('static_assert(kInverseTable.isSorted(), "Inverse table distances must be strictly increasing");\n')
+            if monotonic:
+                f.write('static_assert(kLookupTable.isMonotonic(), "Lookup table distances must be monotonic");\n')
+            if uniform:
+                f.write('static_assert(kLookupTable.isUniform(), "Lookup table positions must be evenly spaced");\n')
+            f.write("\n")
+            
+            f.write("// C-style entry points, same names as the generated C header\n")
+            f.write("constexpr inline float getNearestDistance(float position) {\n")
+            f.write("    return kLookupTable.getNearestDistance(position);\n")
+            f.write("}\n\n")
+            f.write("// Searches the sorted inverse table, so non-monotonic sensor error is handled\n")
+            f.write("constexpr inline float getNearestPosition(float distance) {\n")
+            f.write("    return kInverseTable.getNearestPosition(distance);\n")
+            f.write("}\n\n")
+            
+            f.write(f"#endif // {guard}\n")
+    
+    def write_compressed_c_header(self, filepath, lut, max_error):
+        """Write the knot-reduced lookup table as a drop-in lookup_table.h"""
+        compressed = lut.compress(max_error)
+        if compressed is None:
+            raise ValueError("Compressed layout needs a compiled table with at least 2 entries")
+        knot_positions, knot_distances, worst_error = compressed
+        
+        bins = len(lut.compiled_positions)
+        knots = len(knot_positions)
+        print(f"Compressed {bins} bins ({bins * 8} bytes) to {knots} knots ({knots * 8} bytes), "
+              f"worst-case error {worst_error:.4f}mm (limit {max_error}mm)")
+        
+        with open(filepath, 'w', encoding='utf-8') as f:
+            f.write(f"// Sensor Distance Lookup Table: {lut.name}\n")
+            f.write(f"// Generated: {datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S')}\n")
+            f.write(f"// Bin Size: {lut.metadata.get('bin_size', 'N/A')} mm\n")
+            f.write(f"// Method: {lut.metadata.get('method', 'N/A')}\n")
+            f.write(f"// Layout: compressed, {knots} linear knots from {bins} bins "
+                    f"({knots * 8} bytes instead of {bins * 8})\n")
+            f.write(f"// Max error vs compiled bins: {worst_error:.4f} mm (limit {max_error} mm)\n\n")
+            
+            guard = lut.name.upper().replace(' ', '_') + "_H"
+            f.write(f"#ifndef {guard}\n")
+            f.write(f"#define {guard}\n\n")
+            
+            f.write(f"#define LOOKUP_TABLE_SIZE {knots}\n")
+            f.write("#define LOOKUP_TABLE_COMPRESSED 1\n\n")
+            
+            f.write("// Knot position array (mm)\n")
+            f.write("static const float positions[LOOKUP_TABLE_SIZE] = {\n")
+            for i, pos in enumerate(knot_positions):
+                comma = "," if i < knots - 1 else ""
+                f.write(f"    {pos:.4f}f{comma}\n")
+            f.write("};\n\n")
+            
+            f.write("// Knot distance array (mm)\n")
+            f.write("static const float distances[LOOKUP_TABLE_SIZE] = {\n")
+            for i, dist in enumerate(knot_distances):
+                comma = "," if i < knots - 1 else ""
+                f.write(f"    {dist:.4f}f{comma}\n")
+            f.write("};\n\n")
+            
+            self.write_search_functions(f, knot_positions, knot_distances)
+            
+            f.write(f"#endif // {guard}\n")
+    
+    def write_fused_c_header(self, filepath, lut, error_path, max_error):
+        """Write error correction + lookup table fused into one table (one search per frame)"""
+        error_raw, error_corrected = load_error_correction_table(error_path)
+        fused = lut.fuse(error_raw, error_corrected, max_error)
+        if fused is None:
+            raise ValueError("Fused layout needs a compiled table with at least 2 entries")
+        knot_inputs, knot_outputs, worst_error = fused
+        knots = len(knot_inputs)
+        print(f"Fused {len(error_raw)}-entry error table and {len(lut.compiled_positions)}-bin lookup table "
+              f"into {knots} knots, worst-case error {worst_error:.4f}mm (limit {max_error}mm)")
+        
+        with open(filepath, 'w', encoding='utf-8') as f:
+            f.write(f"// Sensor Distance Lookup Table: {lut.name}\n")
+            f.write(f"// Generated: {datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S')}\n")
+            f.write(f"// Bin Size: {lut.metadata.get('bin_size', 'N/A')} mm\n")
+            f.write(f"// Method: {lut.metadata.get('method', 'N/A')}\n")
+            f.write(f"// Layout: fused with {os.path.basename(error_path)}, {knots} linear knots\n")
+            f.write("// Maps raw sensor distance (mm) straight to the final corrected distance (mm):\n")
+            f.write("// error correction, position lookup and the 2 mm arbitration are precomputed.\n")
+            f.write(f"// Max error vs sampled composition: {worst_error:.4f} mm (limit {max_error} mm)\n\n")
+            
+            guard = lut.name.upper().replace(' ', '_') + "_H"
+            f.write(f"#ifndef {guard}\n")
+            f.write(f"#define {guard}\n\n")
+            
+            f.write(f"#define LOOKUP_TABLE_SIZE {knots}\n")
+            f.write("#define LOOKUP_TABLE_FUSED 1\n\n")
+            
+            f.write("// Raw sensor distance knots (mm)\n")
+            f.write("static const float positions[LOOKUP_TABLE_SIZE] = {\n")
+            for i, raw in enumerate(knot_inputs):
+                comma = "," if i < knots - 1 else ""
+                f.write(f"    {raw:.4f}f{comma}\n")
+            f.write("};\n\n")
+            
+            f.write("// Final corrected distance at each knot (mm)\n")
+            f.write("static const float distances[LOOKUP_TABLE_SIZE] = {\n")
+            for i, dist in enumerate(knot_outputs):
+                comma = "," if i < knots - 1 else ""
+                f.write(f"    {dist:.4f}f{comma}\n")
+            f.write("};\n\n")
+            
+            self.write_search_functions(f, knot_inputs, knot_outputs)
+            
+            f.write(f"#endif // {guard}\n")
+    
+    def write_search_functions(self, f, positions, distances):
+        """
+        Write the inverse table and the binary-search interpolation functions
+        used by lookup_table.h, for the positions[] / distances[] just written.
+        """
+        inverse_distances, inverse_positions = inverse_table(distances, positions, decimals=4)
+        
+        f.write("// Inverse table size (distances sorted, duplicates averaged)\n")
+        f.write(f"#define INVERSE_TABLE_SIZE {len(inverse_distances)}\n")
+        f.write(f"#define INVERSE_DISTANCE_MIN {inverse_distances[0]:.4f}f\n")
+        f.write(f"#define INVERSE_DISTANCE_MAX {inverse_distances[-1]:.4f}f\n\n")
+        
+        f.write("// Inverse distance array (mm), strictly increasing\n")
+        f.write("static const float inverse_distances[INVERSE_TABLE_SIZE] = {\n")
+        for i, dist in enumerate(inverse_distances):
+            comma = "," if i < len(inverse_distances) - 1 else ""
+            f.write(f"    {dist:.4f}f{comma}\n")
+        f.write("};\n\n")
+        
+        f.write("// Inverse position array (mm)\n")
+        f.write("static const float inverse_positions[INVERSE_TABLE_SIZE] = {\n")
+        for i, pos in enumerate(inverse_positions):
+            comma = "," if i < len(inverse_positions) - 1 else ""
+            f.write(f"    {pos:.4f}f{comma}\n")
+        f.write("};\n\n")
+        
+        f.write("// Find the interpolation segment for a key (binary search)\n")
+        f.write("// Returns i in [0, size - 2] with keys[i] <= key < keys[i + 1]; keys outside\n")
+        f.write("// the table land in the first or last segment. keys[] must be sorted ascending.\n")
+        f.write("static inline int lookupBracketIndex(const float *keys, int size, float key) {\n")
+        f.write("    int base = 0;\n")
+        f.write("    int len = size - 1;\n")
+        f.write("    \n")
+        f.write("    while (len > 1) {\n")
+        f.write("        int half = len / 2;\n")
+        f.write("        base = (keys[base + half] <= key) ? base + half : base;\n")
+        f.write("        len -= half;\n")
+        f.write("    }\n")
+        f.write("    \n")
+        f.write("    return base;\n")
+        f.write("}\n\n")
+        
+        f.write("// Interpolate ys[] at x over sorted xs[]\n")
+        f.write("// Exact matches and out-of-range inputs are handled by clamping the segment\n")
+        f.write("// weight, so the table is only searched once.\n")
+        f.write("static inline float lookupInterpolate(const float *xs, const float *ys, int size, float x) {\n")
+        f.write("    if (size == 0) return -1.0f;\n")
+        f.write("    if (size == 1) return ys[0];\n")
+        f.write("    \n")
+        f.write("    int i = lookupBracketIndex(xs, size, x);\n")
+        f.write("    float dx = xs[i + 1] - xs[i];\n")
+        f.write("    float t = (dx > 0.0f) ? (x - xs[i]) / dx : 0.0f;\n")
+        f.write("    t = (t < 0.0f) ? 0.0f : t;\n")
+        f.write("    t = (t > 1.0f) ? 1.0f : t;\n")
+        f.write("    \n")
+        f.write("    // Weighted form returns ys[i] / ys[i + 1] exactly at t == 0 / t == 1\n")
+        f.write("    return ys[i] * (1.0f - t) + ys[i + 1] * t;\n")
+        f.write("}\n\n")
+        
+        f.write("// Function to get nearest distance for a position (interpolated)\n")
+        f.write("static inline float getNearestDistance(float position) {\n")
+        f.write("    return lookupInterpolate(positions, distances, LOOKUP_TABLE_SIZE, position);\n")
+        f.write("}\n\n")
+        
+        f.write("// Function to get the nearest position given a distance (reverse lookup)\n")
+        f.write("// Searches the sorted inverse table, so non-monotonic sensor error is handled\n")
+        f.write("static inline float getNearestPosition(float distance) {\n")
+        f.write("    if (distance <= INVERSE_DISTANCE_MIN) return inverse_positions[0];\n")
+        f.write("    if (distance >= INVERSE_DISTANCE_MAX) return inverse_positions[INVERSE_TABLE_SIZE - 1];\n")
+        f.write("    return lookupInterpolate(inverse_distances, inverse_positions, INVERSE_TABLE_SIZE, distance);\n")
+        f.write("}\n\n")
+    
     def test_lookup_dialog(self):
         """Open test lookup dialog"""
         self.right_notebook.select(2)  # Switch to test tab
@@ -1050,18 +1899,28 @@ class LookupTableGUI:
             messagebox.showwarning("Warning", "No lookup table selected")
             return
         
-        self.corrected_data = []
-        for row in self.batch_data:
-            new_row = list(row)
+        # Parse the sensor distance column, then correct every row in one batch
+        row_indices = []
+        sensor_distances = []
+        for i, row in enumerate(self.batch_data):
             try:
                 if len(row) >= 1:
-                    sensor_distance = float(row[0])
-                    corrected = self.current_lut.reverse_lookup(sensor_distance)
-                    if corrected is not None:
-                        new_row.append(f"{corrected:.2f}")
-                    else:
-                        new_row.append("N/A")
+                    sensor_distances.append(float(row[0]))
+                    row_indices.append(i)
             except ValueError:
+                continue
+        
+        corrected_values = None
+        if sensor_distances:
+            corrected_values = self.current_lut.reverse_lookup_batch(sensor_distances)
+        corrected_by_row = dict(zip(row_indices, corrected_values)) if corrected_values is not None else {}
+        
+        self.corrected_data = []
+        for i, row in enumerate(self.batch_data):
+            new_row = list(row)
+            if i in corrected_by_row:
+                new_row.append(f"{corrected_by_row[i]:.2f}")
+            elif len(row) >= 1:
                 new_row.append("N/A")
             self.corrected_data.append(new_row)
         
@@ -1179,15 +2038,16 @@ class LookupTableGUI:
             'out_of_range_count': 0
         }
         
-        # Use reverse_lookup to get true position for each sensor distance
-        for distance in self.tds_data['distances']:
-            true_position = self.current_lut.reverse_lookup(distance)
-            if true_position is not None:
-                self.corrected_tds_data['corrected_positions'].append(true_position)
-            else:
-                # Out of range - use original distance
-                self.corrected_tds_data['corrected_positions'].append(distance)
-                self.corrected_tds_data['out_of_range_count'] += 1
+        # Reverse lookup every sensor distance in one batch call
+        distances = np.asarray(self.tds_data['distances'], dtype=np.float64)
+        corrected_positions = self.current_lut.reverse_lookup_batch(distances)
+        self.corrected_tds_data['corrected_positions'] = [float(p) for p in corrected_positions]
+        
+        # Inputs outside the table are clamped to the end entries
+        lut_min = min(self.current_lut.compiled_distances)
+        lut_max = max(self.current_lut.compiled_distances)
+        self.corrected_tds_data['out_of_range_count'] = int(
+            np.count_nonzero((distances < lut_min) | (distances > lut_max)))
         
         # Calculate new deltas (corrected_position - reference_position)
         self.corrected_tds_data['corrected_deltas'] = [
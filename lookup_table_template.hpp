@@ -0,0 +1,133 @@
+// Sensor Distance Lookup Table Template
+// Header-only constexpr lookup table for C++ builds (C++17).
+// The generator instantiates LookupTable<N, Layout> with the compiled data, so
+// ordering is checked with static_assert and constant lookups fold at compile time.
+
+#ifndef LOOKUP_TABLE_TEMPLATE_HPP
+#define LOOKUP_TABLE_TEMPLATE_HPP
+
+#include <cstddef>
+#include <utility>
+
+// Lookup strategy, picked at compile time
+enum class LutLayout {
+    Search,  // Sorted positions, binary search (unrolled compare for small tables)
+    Uniform  // Evenly spaced positions, direct index
+};
+
+// Tables up to this size use a fully unrolled, branch-free segment search
+constexpr std::size_t kLutUnrollLimit = 8;
+
+template <std::size_t N, LutLayout Layout = LutLayout::Search>
+struct LookupTable {
+    static_assert(N >= 2, "Lookup table needs at least two entries");
+
+    float positions[N];  // Position array (mm)
+    float distances[N];  // Distance array (mm)
+    float inv_step = uniformInvStep(positions);  // Grid cells per mm, Uniform only (0 for Search)
+
+    // Positions must be strictly increasing for any lookup
+    constexpr bool isSorted() const {
+        for (std::size_t i = 0; i + 1 < N; i++) {
+            if (!(positions[i] < positions[i + 1])) return false;
+        }
+        return true;
+    }
+
+    // Distances non-decreasing, i.e. the sensor error is monotonic
+    constexpr bool isMonotonic() const {
+        for (std::size_t i = 0; i + 1 < N; i++) {
+            if (distances[i + 1] < distances[i]) return false;
+        }
+        return true;
+    }
+
+    // Positions must be evenly spaced (within tolerance mm) for LutLayout::Uniform
+    constexpr bool isUniform(float tolerance = 1e-3f) const {
+        const float step = (positions[N - 1] - positions[0]) / static_cast<float>(N - 1);
+        for (std::size_t i = 0; i + 1 < N; i++) {
+            float error = (positions[i + 1] - positions[i]) - step;
+            if (error > tolerance || error < -tolerance) return false;
+        }
+        return true;
+    }
+
+    // Get nearest distance for a position (interpolated, clamped to the ends; NaN gives NaN)
+    constexpr float getNearestDistance(float position) const {
+        return interpolate(positions, distances, positionSegment(position), position);
+    }
+
+private:
+    // Only the uniform layout indexes by position, and a zero span would divide by zero
+    static constexpr float uniformInvStep(const float (&keys)[N]) {
+        if constexpr (Layout == LutLayout::Uniform) {
+            float span = keys[N - 1] - keys[0];
+            return (span > 0.0f) ? static_cast<float>(N - 1) / span : 0.0f;
+        } else {
+            return 0.0f;
+        }
+    }
+
+    constexpr std::size_t positionSegment(float position) const {
+        if constexpr (Layout == LutLayout::Uniform) {
+            // Clamp before the conversion, which is undefined (and not a constant
+            // expression) for values out of range; !(u > 0) also catches NaN
+            float u = (position - positions[0]) * inv_step;
+            if (!(u > 0.0f)) return 0;
+            if (u >= static_cast<float>(N - 2)) return N - 2;
+            return static_cast<std::size_t>(u);
+        } else {
+            return searchSegment(positions, position);
+        }
+    }
+
+    // Returns i in [0, N - 2] with keys[i] <= key < keys[i + 1], clamped to the ends
+    static constexpr std::size_t searchSegment(const float (&keys)[N], float key) {
+        if constexpr (N <= kLutUnrollLimit) {
+            return countAtOrBelow(keys, key, std::make_index_sequence<N - 2>{});
+        } else {
+            std::size_t base = 0;
+            std::size_t len = N - 1;
+            while (len > 1) {
+                std::size_t half = len / 2;
+                base = (keys[base + half] <= key) ? base + half : base;
+                len -= half;
+            }
+            return base;
+        }
+    }
+
+    // Unrolled search: count interior breakpoints at or below the key
+    template <std::size_t... I>
+    static constexpr std::size_t countAtOrBelow(const float (&keys)[N], float key, std::index_sequence<I...>) {
+        return (std::size_t{0} + ... + static_cast<std::size_t>(keys[I + 1] <= key));
+    }
+
+    static constexpr float interpolate(const float (&xs)[N], const float (&ys)[N], std::size_t i, float x) {
+        float dx = xs[i + 1] - xs[i];
+        float t = (dx > 0.0f) ? (x - xs[i]) / dx : 0.0f;
+        t = (t < 0.0f) ? 0.0f : t;
+        t = (t > 1.0f) ? 1.0f : t;
+        return ys[i] * (1.0f - t) + ys[i + 1] * t;
+    }
+};
+
+// Reverse (distance -> position) table for getNearestPosition(). The generator
+// sorts the distances and averages duplicates, so it stays searchable when the
+// sensor error is not monotonic; it is a LookupTable keyed on distance.
+template <std::size_t M>
+struct InverseLookupTable {
+    LookupTable<M, LutLayout::Search> table;  // positions[] hold distances, distances[] hold positions
+
+    // Distances must be strictly increasing
+    constexpr bool isSorted() const {
+        return table.isSorted();
+    }
+
+    // Get the nearest position given a distance (reverse lookup)
+    constexpr float getNearestPosition(float distance) const {
+        return table.getNearestDistance(distance);
+    }
+};
+
+#endif // LOOKUP_TABLE_TEMPLATE_HPP
@@ -0,0 +1,157 @@
+// Batch Lookup Table Correction
+// Scalar and AVX2 implementations of correct_batch(), loaded from Python by
+// lut_batch.py.
+//
+// Build:
+//   gcc -O3 -shared -fPIC lut_batch.c -o lut_batch.so    (Linux)
+//   gcc -O3 -shared lut_batch.c -o lut_batch.dll         (Windows, MinGW)
+
+#include "lut_batch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LUT_BATCH_X86 1
+#endif
+
+static const float *bound_keys   = NULL;
+static const float *bound_values = NULL;
+static size_t      bound_size    = 0;
+
+void lut_batch_bind(const float *keys, const float *values, size_t size)
+{
+        bound_keys   = keys;
+        bound_values = values;
+        bound_size   = size;
+}
+
+// Same search and interpolation as lookupInterpolate() in lookup_table.h
+static float correct_one(float x)
+{
+        size_t base = 0;
+        size_t len  = bound_size - 1;
+
+        while (len > 1)
+        {
+                size_t half = len / 2;
+                base = (bound_keys[base + half] <= x) ? base + half : base;
+                len -= half;
+        }
+
+        float dx = bound_keys[base + 1] - bound_keys[base];
+        float t  = (dx > 0.0f) ? (x - bound_keys[base]) / dx : 0.0f;
+        t = (t < 0.0f) ? 0.0f : t;
+        t = (t > 1.0f) ? 1.0f : t;
+
+        return bound_values[base] * (1.0f - t) + bound_values[base + 1] * t;
+}
+
+// Tables with fewer than two entries cannot interpolate
+static int handle_degenerate(const float *in, float *out, size_t n)
+{
+        if (bound_size >= 2)
+        {
+                return 0;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+                out[i] = (bound_size == 1) ? bound_values[0] : in[i];
+        }
+
+        return 1;
+}
+
+void correct_batch_scalar(const float *in, float *out, size_t n)
+{
+        if (handle_degenerate(in, out, n))
+        {
+                return;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+                out[i] = correct_one(in[i]);
+        }
+}
+
+#ifdef LUT_BATCH_X86
+
+// Eight lanes run the same branch-free binary search; the step sequence only
+// depends on the table size, so every lane takes the same number of steps.
+__attribute__((target("avx2,fma")))
+static void correct_batch_avx2(const float *in, float *out, size_t n)
+{
+        const __m256  zero = _mm256_setzero_ps();
+        const __m256  one  = _mm256_set1_ps(1.0f);
+        const __m256i next = _mm256_set1_epi32(1);
+        size_t        i    = 0;
+
+        for (; i + 8 <= n; i += 8)
+        {
+                __m256  x    = _mm256_loadu_ps(in + i);
+                __m256i base = _mm256_setzero_si256();
+                size_t  len  = bound_size - 1;
+
+                while (len > 1)
+                {
+                        size_t  half  = len / 2;
+                        __m256i probe = _mm256_add_epi32(base, _mm256_set1_epi32((int)half));
+                        __m256  key   = _mm256_i32gather_ps(bound_keys, probe, 4);
+                        __m256  le    = _mm256_cmp_ps(key, x, _CMP_LE_OQ);
+                        base = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(base),
+                                                                    _mm256_castsi256_ps(probe), le));
+                        len -= half;
+                }
+
+                __m256i upper = _mm256_add_epi32(base, next);
+                __m256  x0    = _mm256_i32gather_ps(bound_keys, base, 4);
+                __m256  x1    = _mm256_i32gather_ps(bound_keys, upper, 4);
+                __m256  y0    = _mm256_i32gather_ps(bound_values, base, 4);
+                __m256  y1    = _mm256_i32gather_ps(bound_values, upper, 4);
+
+                __m256 dx = _mm256_sub_ps(x1, x0);
+                __m256 t  = _mm256_div_ps(_mm256_sub_ps(x, x0), dx);
+                t = _mm256_and_ps(t, _mm256_cmp_ps(dx, zero, _CMP_GT_OQ));
+                t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+
+                __m256 y = _mm256_fmadd_ps(y1, t, _mm256_mul_ps(y0, _mm256_sub_ps(one, t)));
+
+                // max/min above turn a NaN weight into 0; pass NaN through like correct_one()
+                y = _mm256_blendv_ps(y, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+                _mm256_storeu_ps(out + i, y);
+        }
+
+        for (; i < n; i++)
+        {
+                out[i] = correct_one(in[i]);
+        }
+}
+
+#endif
+
+int lut_batch_has_avx2(void)
+{
+#ifdef LUT_BATCH_X86
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        return 0;
+#endif
+}
+
+void correct_batch(const float *in, float *out, size_t n)
+{
+        if (handle_degenerate(in, out, n))
+        {
+                return;
+        }
+
+#ifdef LUT_BATCH_X86
+        if (lut_batch_has_avx2() && bound_size <= 0x7FFFFFFF)
+        {
+                correct_batch_avx2(in, out, n);
+                return;
+        }
+#endif
+
+        correct_batch_scalar(in, out, n);
+}
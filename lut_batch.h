@@ -0,0 +1,33 @@
+// Batch Lookup Table Correction
+// Host-side whole-dataset correction over the same sorted key/value layout as
+// the generated lookup_table.h (positions[] / distances[]).
+
+#ifndef LUT_BATCH_H
+#define LUT_BATCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bind the table used by correct_batch(); keys[] must be sorted ascending.
+// The arrays are not copied and must outlive the correct_batch() calls.
+void lut_batch_bind(const float *keys, const float *values, size_t size);
+
+// Interpolate every input through the bound table (clamped at both ends).
+// NaN inputs give NaN outputs on both paths.
+// Uses the AVX2 path when the CPU supports it, the scalar path otherwise.
+void correct_batch(const float *in, float *out, size_t n);
+
+// Scalar reference path, always available
+void correct_batch_scalar(const float *in, float *out, size_t n);
+
+// Returns 1 if correct_batch() dispatches to the AVX2 path
+int lut_batch_has_avx2(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LUT_BATCH_H
@@ -0,0 +1,119 @@
+"""
+Batch Lookup Table Correction
+Thin ctypes binding for lut_batch.c (AVX2 + scalar correct_batch()).
+Falls back to numpy.interp when the shared library has not been built.
+
+Build the library next to this file:
+    gcc -O3 -shared -fPIC lut_batch.c -o lut_batch.so    (Linux)
+    gcc -O3 -shared lut_batch.c -o lut_batch.dll         (Windows, MinGW)
+"""
+
+import os
+import bisect
+import ctypes
+import numpy as np
+
+
+def _load_library():
+    """Load the compiled lut_batch library if present, otherwise return None"""
+    lib_dir = os.path.dirname(os.path.abspath(__file__))
+    for name in ("lut_batch.dll", "lut_batch.so", "lut_batch.dylib"):
+        path = os.path.join(lib_dir, name)
+        if not os.path.exists(path):
+            continue
+        try:
+            lib = ctypes.CDLL(path)
+        except OSError:
+            continue
+
+        float_p = ctypes.POINTER(ctypes.c_float)
+        lib.lut_batch_bind.argtypes = [float_p, float_p, ctypes.c_size_t]
+        lib.lut_batch_bind.restype = None
+        lib.correct_batch.argtypes = [float_p, float_p, ctypes.c_size_t]
+        lib.correct_batch.restype = None
+        lib.lut_batch_has_avx2.argtypes = []
+        lib.lut_batch_has_avx2.restype = ctypes.c_int
+        return lib
+    return None
+
+
+_lib = _load_library()
+
+
+def backend_name():
+    """Describe which implementation correct() will use"""
+    if _lib is None:
+        return "numpy"
+    return "native (AVX2)" if _lib.lut_batch_has_avx2() else "native (scalar)"
+
+
+def inverse_table(distances, positions, decimals=None):
+    """
+    Build the inverse (distance -> position) table used by reverse lookups.
+
+    Distances are sorted and duplicates averaged, so the table stays
+    searchable when the sensor error is not monotonic. With decimals set,
+    distances are grouped as rounded to that many places, so the table stays
+    strictly increasing once written out at that precision.
+
+    Returns:
+        (inverse_distances, inverse_positions) as lists
+    """
+    grouped = {}
+    for pos, dist in zip(positions, distances):
+        key = float(dist) if decimals is None else round(float(dist), decimals)
+        grouped.setdefault(key, []).append(float(pos))
+
+    inverse_distances = sorted(grouped)
+    inverse_positions = [sum(grouped[d]) / len(grouped[d]) for d in inverse_distances]
+    return inverse_distances, inverse_positions
+
+
+class BatchCorrector:
+    """Interpolates whole arrays through a key -> value table in one call"""
+
+    def __init__(self, keys, values):
+        keys = np.asarray(keys, dtype=np.float32)
+        values = np.asarray(values, dtype=np.float32)
+
+        # correct_batch() needs ascending keys
+        order = np.argsort(keys, kind='stable')
+        self.keys = np.ascontiguousarray(keys[order])
+        self.values = np.ascontiguousarray(values[order])
+        
+        # Plain lists for correct_one(), which skips numpy and ctypes
+        self._key_list = [float(k) for k in self.keys]
+        self._value_list = [float(v) for v in self.values]
+
+    def correct(self, inputs):
+        """Return corrected values for every input (clamped at the table ends)"""
+        x = np.ascontiguousarray(inputs, dtype=np.float32)
+
+        if _lib is None:
+            return np.interp(x, self.keys, self.values).astype(np.float32)
+
+        out = np.empty_like(x)
+        float_p = ctypes.POINTER(ctypes.c_float)
+        _lib.lut_batch_bind(self.keys.ctypes.data_as(float_p),
+                            self.values.ctypes.data_as(float_p),
+                            len(self.keys))
+        _lib.correct_batch(x.ctypes.data_as(float_p), out.ctypes.data_as(float_p), len(x))
+        return out
+
+    def correct_one(self, value):
+        """
+        Correct a single value, for live per-frame use where the call overhead
+        of correct() outweighs the lookup. Same clamped interpolation as
+        correct_batch().
+        """
+        keys, values = self._key_list, self._value_list
+        if len(keys) < 2:
+            return values[0] if keys else value
+        if value != value:
+            return value
+        
+        i = min(max(bisect.bisect_right(keys, value) - 1, 0), len(keys) - 2)
+        dx = keys[i + 1] - keys[i]
+        t = (value - keys[i]) / dx if dx > 0 else 0.0
+        t = min(max(t, 0.0), 1.0)
+        return values[i] * (1.0 - t) + values[i + 1] * t
@@ -0,0 +1,266 @@
+// Runtime Lookup Table Download
+// Double-buffered RAM lookup table filled over CAN, see lut_download.h.
+
+#include "lut_download.h"
+
+#include <string.h>
+
+#include "can_tx_queue.h"
+#include "main.h"
+
+typedef struct
+{
+        float    positions[LUT_DOWNLOAD_MAX_SIZE];
+        float    distances[LUT_DOWNLOAD_MAX_SIZE];
+        uint16_t size;
+        uint32_t crc;
+} lut_bank_t;
+
+static lut_bank_t banks[2];
+
+// Read by the measurement loop, only changed by lut_download_poll()
+static const lut_bank_t *volatile active_bank = NULL;
+
+// Written by the CAN RX interrupt, always the bank that is not active
+static lut_bank_t *rx_bank         = &banks[0];
+static uint32_t   rx_crc          = 0;
+static uint32_t   rx_next_word    = 0;
+static uint32_t   rx_expected_crc = 0;
+
+static volatile uint8_t rx_state       = LUT_DOWNLOAD_IDLE;
+static volatile uint8_t rx_error       = LUT_DOWNLOAD_OK;
+static volatile bool    status_dirty   = false;
+static volatile bool    progress_dirty = false;
+
+// CRC-32 (reflected 0xEDB88320), one nibble per table lookup to keep flash use small
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+        static const uint32_t nibble_table[16] = {
+                0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+                0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+        };
+
+        crc = ~crc;
+        for (uint32_t i = 0; i < len; i++)
+        {
+                crc = (crc >> 4) ^ nibble_table[(crc ^ data[i]) & 0x0F];
+                crc = (crc >> 4) ^ nibble_table[(crc ^ (data[i] >> 4)) & 0x0F];
+        }
+
+        return ~crc;
+}
+
+static void fail(lut_download_error_t error)
+{
+        rx_state     = LUT_DOWNLOAD_FAILED;
+        rx_error     = error;
+        status_dirty = true;
+}
+
+static void handle_begin(const uint8_t *data)
+{
+        uint16_t size = ((uint16_t)data[0] << 8) | data[1];
+
+        if (size < 2 || size > LUT_DOWNLOAD_MAX_SIZE)
+        {
+                fail(LUT_DOWNLOAD_ERR_SIZE);
+                return;
+        }
+
+        // A BEGIN while PENDING drops the verified table that was not swapped in yet
+        rx_bank         = (active_bank == &banks[0]) ? &banks[1] : &banks[0];
+        rx_bank->size   = size;
+        rx_expected_crc = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) |
+                          ((uint32_t)data[4] << 8) | data[5];
+        rx_crc          = 0;
+        rx_next_word    = 0;
+        rx_state        = LUT_DOWNLOAD_RECEIVING;
+        rx_error        = LUT_DOWNLOAD_OK;
+        status_dirty    = true;
+        progress_dirty  = false;
+}
+
+static void handle_data(const uint8_t *data)
+{
+        uint32_t word = ((uint32_t)data[0] << 8) | data[1];
+        uint32_t bits = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) |
+                        ((uint32_t)data[4] << 8) | data[5];
+        float    value;
+
+        if (rx_state != LUT_DOWNLOAD_RECEIVING)
+        {
+                return;
+        }
+
+        // A lost frame shows up as a gap, a resent one as a repeat: drop the
+        // word and report where to resume
+        if (word != rx_next_word || word >= 2U * rx_bank->size)
+        {
+                progress_dirty = true;
+                return;
+        }
+
+        memcpy(&value, &bits, sizeof(value));
+
+        if (word < rx_bank->size)
+        {
+                if (word > 0 && !(value > rx_bank->positions[word - 1]))
+                {
+                        fail(LUT_DOWNLOAD_ERR_NOT_SORTED);
+                        return;
+                }
+                rx_bank->positions[word] = value;
+        }
+        else
+        {
+                rx_bank->distances[word - rx_bank->size] = value;
+        }
+
+        rx_crc = crc32_update(rx_crc, &data[2], 4);
+        rx_next_word++;
+
+        if (rx_next_word % LUT_DOWNLOAD_ACK_WORDS == 0 || rx_next_word == 2U * rx_bank->size)
+        {
+                progress_dirty = true;
+        }
+}
+
+static void handle_commit(void)
+{
+        if (rx_state != LUT_DOWNLOAD_RECEIVING)
+        {
+                fail(LUT_DOWNLOAD_ERR_SEQUENCE);
+                return;
+        }
+
+        if (rx_next_word != 2U * rx_bank->size)
+        {
+                fail(LUT_DOWNLOAD_ERR_INCOMPLETE);
+                return;
+        }
+
+        if (rx_crc != rx_expected_crc)
+        {
+                fail(LUT_DOWNLOAD_ERR_CRC);
+                return;
+        }
+
+        rx_bank->crc = rx_crc;
+        rx_state     = LUT_DOWNLOAD_PENDING;
+        status_dirty = true;
+}
+
+void lut_download_can_rx(uint32_t id, const uint8_t *data)
+{
+        switch (id)
+        {
+                case LUT_DOWNLOAD_CAN_BEGIN:
+                        handle_begin(data);
+                        break;
+                case LUT_DOWNLOAD_CAN_DATA:
+                        handle_data(data);
+                        break;
+                case LUT_DOWNLOAD_CAN_COMMIT:
+                        handle_commit();
+                        break;
+                default:
+                        break;
+        }
+}
+
+static void send_status(uint8_t state, uint8_t error)
+{
+        const lut_bank_t *bank = active_bank;
+        uint16_t         size  = bank ? bank->size : 0;
+        uint32_t         crc   = bank ? bank->crc : 0;
+        uint8_t          data[8];
+
+        data[0] = state;
+        data[1] = error;
+        data[2] = (size >> 8) & 0xFF;
+        data[3] = size & 0xFF;
+        data[4] = (crc >> 24) & 0xFF;
+        data[5] = (crc >> 16) & 0xFF;
+        data[6] = (crc >> 8) & 0xFF;
+        data[7] = crc & 0xFF;
+
+        can_tx_queue_send(LUT_DOWNLOAD_CAN_STATUS, data);
+}
+
+static void send_progress(uint16_t next_word, uint16_t total_words)
+{
+        uint8_t data[8] = {0};
+
+        data[0] = (next_word >> 8) & 0xFF;
+        data[1] = next_word & 0xFF;
+        data[2] = (total_words >> 8) & 0xFF;
+        data[3] = total_words & 0xFF;
+
+        can_tx_queue_send(LUT_DOWNLOAD_CAN_PROGRESS, data);
+}
+
+void lut_download_poll(void)
+{
+        bool     send;
+        bool     progress;
+        uint8_t  state;
+        uint8_t  error;
+        uint16_t next_word;
+        uint16_t total_words;
+
+        // The RX interrupt must not start a new BEGIN between the check and the swap;
+        // PRIMASK is restored, not cleared, in case the caller has interrupts masked
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (rx_state == LUT_DOWNLOAD_PENDING)
+        {
+                active_bank  = rx_bank;
+                rx_state     = LUT_DOWNLOAD_IDLE;
+                status_dirty = true;
+        }
+        send           = status_dirty;
+        state          = rx_state;
+        error          = rx_error;
+        status_dirty   = false;
+        progress       = progress_dirty && rx_state == LUT_DOWNLOAD_RECEIVING;
+        next_word      = (uint16_t)rx_next_word;
+        total_words    = (uint16_t)(2U * rx_bank->size);
+        progress_dirty = false;
+        __set_PRIMASK(primask);
+
+        if (send)
+        {
+                send_status(state, error);
+        }
+        if (progress)
+        {
+                send_progress(next_word, total_words);
+        }
+}
+
+bool lut_download_active(void)
+{
+        return active_bank != NULL;
+}
+
+// Same search and interpolation as lookupInterpolate() in lookup_table.h
+float lut_download_lookup(float position)
+{
+        const lut_bank_t *bank = active_bank;
+        uint32_t         base  = 0;
+        uint32_t         len   = bank->size - 1U;
+
+        while (len > 1)
+        {
+                uint32_t half = len / 2;
+                base = (bank->positions[base + half] <= position) ? base + half : base;
+                len -= half;
+        }
+
+        float dx = bank->positions[base + 1] - bank->positions[base];
+        float t  = (dx > 0.0f) ? (position - bank->positions[base]) / dx : 0.0f;
+        t = (t < 0.0f) ? 0.0f : t;
+        t = (t > 1.0f) ? 1.0f : t;
+
+        return bank->distances[base] * (1.0f - t) + bank->distances[base + 1] * t;
+}
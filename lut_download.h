@@ -0,0 +1,80 @@
+// Runtime Lookup Table Download
+// Receives a compiled lookup table over CAN into the inactive one of two RAM
+// banks, verifies it with CRC-32 and swaps it in between measurement frames.
+//
+// Protocol (classic CAN, 8 data bytes, big-endian):
+//   0x610 BEGIN   host -> sensor  count (u16), CRC-32 (u32), reserved (2)
+//   0x611 DATA    host -> sensor  word index (u16), float bits (u32), reserved (2)
+//                                 words 0..count-1 are positions, count..2*count-1 distances
+//   0x612 COMMIT  host -> sensor  reserved (8); verify, swap in before the next frame
+//   0x613 STATUS  sensor -> host  state (u8), error (u8), active count (u16), active CRC-32 (u32)
+//   0x614 PROGRESS sensor -> host next expected word (u16), total words (u16), reserved (4)
+//
+// The CRC-32 (IEEE 802.3, as zlib.crc32) covers the data words in order.
+//
+// The host paces DATA in windows of LUT_DOWNLOAD_ACK_WORDS and waits for
+// PROGRESS before the next window. PROGRESS is sent once every
+// LUT_DOWNLOAD_ACK_WORDS accepted words, once all words arrived, and after
+// any DATA word that was dropped: a word other than the next expected one
+// (lost or repeated frame) is dropped, not failed, so the host resends from
+// the reported word instead of restarting the download.
+//
+// Integration: call lut_download_can_rx() from HAL_FDCAN_RxFifo0Callback() in
+// fdcan.c (the RX filter must accept 0x610-0x612) and lut_download_poll() once
+// per frame from the measurement loop.
+
+#ifndef LUT_DOWNLOAD_H
+#define LUT_DOWNLOAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LUT_DOWNLOAD_CAN_BEGIN  (0x610U)
+#define LUT_DOWNLOAD_CAN_DATA   (0x611U)
+#define LUT_DOWNLOAD_CAN_COMMIT (0x612U)
+#define LUT_DOWNLOAD_CAN_STATUS (0x613U)
+#define LUT_DOWNLOAD_CAN_PROGRESS (0x614U)
+
+// Entries per bank; RAM use is 2 banks * 2 arrays * 4 bytes per entry
+#ifndef LUT_DOWNLOAD_MAX_SIZE
+#define LUT_DOWNLOAD_MAX_SIZE (512U)
+#endif
+
+// DATA words per acknowledged window; LUT_DOWNLOAD_ACK_WORDS in lut_download.py must match
+#ifndef LUT_DOWNLOAD_ACK_WORDS
+#define LUT_DOWNLOAD_ACK_WORDS (16U)
+#endif
+
+typedef enum
+{
+        LUT_DOWNLOAD_IDLE = 0,  // Nothing in progress
+        LUT_DOWNLOAD_RECEIVING, // BEGIN accepted, DATA words arriving
+        LUT_DOWNLOAD_PENDING,   // Verified, swapped in at the next lut_download_poll()
+        LUT_DOWNLOAD_FAILED     // Last transfer rejected, see lut_download_error_t
+} lut_download_state_t;
+
+typedef enum
+{
+        LUT_DOWNLOAD_OK = 0,
+        LUT_DOWNLOAD_ERR_SIZE,         // Count below 2 or above LUT_DOWNLOAD_MAX_SIZE
+        LUT_DOWNLOAD_ERR_SEQUENCE,     // COMMIT without BEGIN
+        LUT_DOWNLOAD_ERR_NOT_SORTED,   // Positions not strictly increasing
+        LUT_DOWNLOAD_ERR_INCOMPLETE,   // COMMIT before all words arrived
+        LUT_DOWNLOAD_ERR_CRC           // CRC-32 mismatch
+} lut_download_error_t;
+
+// Feed one received CAN frame; ignores IDs outside 0x610-0x612. Interrupt context.
+void lut_download_can_rx(uint32_t id, const uint8_t *data);
+
+// Swap a verified bank in, send 0x613 when the state changed and 0x614 when
+// DATA progress is due. Call between frames.
+void lut_download_poll(void);
+
+// True once a downloaded table is active (it stays active until reset)
+bool lut_download_active(void);
+
+// Interpolate the active downloaded table (positions -> distances), clamped at the ends.
+// Only valid while lut_download_active() is true.
+float lut_download_lookup(float position);
+
+#endif // LUT_DOWNLOAD_H
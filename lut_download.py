@@ -0,0 +1,201 @@
+"""
+Runtime Lookup Table Download
+Streams a compiled lookup table to the sensor over CAN (through the serial
+bridge) using the 0x610-0x614 protocol implemented in lut_download.c.
+The sensor verifies the CRC-32 and swaps the table in between frames.
+
+The bridge only polls its serial port between telemetry frames, and spends
+about 20 ms per frame sampling its ADCs, so frames sent back-to-back can
+overflow its serial RX buffer. DATA words therefore go out paced, in windows
+of LUT_DOWNLOAD_ACK_WORDS, and each window waits for the sensor's 0x614
+progress report; a lost frame is resent from the word the sensor reports.
+"""
+
+import struct
+import time
+import zlib
+
+LUT_DOWNLOAD_CAN_BEGIN = 0x610
+LUT_DOWNLOAD_CAN_DATA = 0x611
+LUT_DOWNLOAD_CAN_COMMIT = 0x612
+
+# Serial frame types the bridge uses for 0x613 status and 0x614 progress
+LUT_STATUS_FRAME = 0xC0
+LUT_PROGRESS_FRAME = 0xC2
+
+# Words per acknowledged window, LUT_DOWNLOAD_ACK_WORDS in lut_download.h
+LUT_DOWNLOAD_ACK_WORDS = 16
+
+# Gap between frames sent to the bridge: a window then spans several bridge
+# loop iterations instead of arriving while it samples its ADCs
+LUT_DOWNLOAD_FRAME_GAP_S = 0.005
+
+# Time to wait for the 0x614 report after a window; the sensor sends it from
+# its measurement loop, so this covers a frame period plus the bridge
+LUT_DOWNLOAD_ACK_TIMEOUT_S = 0.5
+
+# Resends without progress before giving up
+LUT_DOWNLOAD_RETRIES = 5
+
+LUT_DOWNLOAD_MAX_SIZE = 512
+
+STATE_NAMES = {0: "IDLE", 1: "RECEIVING", 2: "PENDING", 3: "FAILED"}
+ERROR_NAMES = {
+    0: "OK",
+    1: "SIZE",
+    2: "SEQUENCE",
+    3: "NOT_SORTED",
+    4: "INCOMPLETE",
+    5: "CRC",
+}
+
+
+def build_frames(positions, distances):
+    """
+    Encode a lookup table as the CAN frames of one download.
+
+    Returns:
+        (frames, crc) with frames a list of (can_id, 8-byte data)
+    """
+    if len(positions) != len(distances):
+        raise ValueError("positions and distances must have the same length")
+    if not 2 <= len(positions) <= LUT_DOWNLOAD_MAX_SIZE:
+        raise ValueError(f"Table size must be 2..{LUT_DOWNLOAD_MAX_SIZE} entries")
+    if any(b <= a for a, b in zip(positions, positions[1:])):
+        raise ValueError("Positions must be strictly increasing")
+
+    words = [struct.pack('>f', v) for v in list(positions) + list(distances)]
+    crc = 0
+    for w in words:
+        crc = zlib.crc32(w, crc)
+
+    frames = [(LUT_DOWNLOAD_CAN_BEGIN, struct.pack('>HI2x', len(positions), crc))]
+    for index, w in enumerate(words):
+        frames.append((LUT_DOWNLOAD_CAN_DATA, struct.pack('>H', index) + w + b'\x00\x00'))
+    frames.append((LUT_DOWNLOAD_CAN_COMMIT, bytes(8)))
+    return frames, crc
+
+
+def parse_status(payload):
+    """Decode a 0x613 status payload into a dict"""
+    state, error, size, crc = struct.unpack('>BBHI', payload[0:8])
+    return {
+        'state': STATE_NAMES.get(state, f"UNKNOWN({state})"),
+        'error': ERROR_NAMES.get(error, f"UNKNOWN({error})"),
+        'active_size': size,
+        'active_crc': crc,
+    }
+
+
+def parse_progress(payload):
+    """Decode a 0x614 progress payload into (next_word, total_words)"""
+    return struct.unpack('>HH', payload[0:4])
+
+
+def _send_paced(sensor, can_id, data):
+    sensor.send_can(can_id, data)
+    time.sleep(LUT_DOWNLOAD_FRAME_GAP_S)
+
+
+def _wait_for(sensor, wanted_type, timeout_s):
+    """Return the payload of the next frame of wanted_type, or None on timeout"""
+    deadline = time.time() + timeout_s
+    while time.time() < deadline:
+        frame_type, payload = sensor.read_frame(timeout_s=0.1)
+        if frame_type == wanted_type and payload and len(payload) >= 8:
+            return payload
+    return None
+
+
+def _begin(sensor, begin_frame, timeout_s):
+    """Send BEGIN until the sensor reports RECEIVING"""
+    for _ in range(LUT_DOWNLOAD_RETRIES):
+        _send_paced(sensor, *begin_frame)
+        deadline = time.time() + timeout_s
+        while time.time() < deadline:
+            payload = _wait_for(sensor, LUT_STATUS_FRAME, deadline - time.time())
+            if payload is None:
+                break
+            status = parse_status(payload)
+            if status['state'] == "RECEIVING":
+                return True
+            if status['state'] == "FAILED":
+                print(f"[LUT] Download rejected: {status['error']}")
+                return False
+    print("[LUT] Sensor did not acknowledge the download")
+    return False
+
+
+def _send_words(sensor, data_frames):
+    """Send DATA in acknowledged windows, resending from the word the sensor reports"""
+    next_word = 0
+    retries = 0
+    while next_word < len(data_frames):
+        # Windows end on LUT_DOWNLOAD_ACK_WORDS boundaries, where the sensor reports
+        end = min((next_word // LUT_DOWNLOAD_ACK_WORDS + 1) * LUT_DOWNLOAD_ACK_WORDS, len(data_frames))
+        for can_id, data in data_frames[next_word:end]:
+            _send_paced(sensor, can_id, data)
+
+        # Reports below the window end are either late ones for an earlier
+        # window or a gap; in both cases resume after the furthest one
+        reported = next_word
+        deadline = time.time() + LUT_DOWNLOAD_ACK_TIMEOUT_S
+        while reported < end:
+            payload = _wait_for(sensor, LUT_PROGRESS_FRAME, deadline - time.time())
+            if payload is None:
+                break
+            reported = max(reported, parse_progress(payload)[0])
+
+        if reported > next_word:
+            next_word = reported
+            retries = 0
+            continue
+
+        # No progress at all: resend the window
+        retries += 1
+        if retries > LUT_DOWNLOAD_RETRIES:
+            print(f"[LUT] Download stalled at word {next_word} of {len(data_frames)}")
+            return False
+    return True
+
+
+def upload_lookup_table(sensor, positions, distances, timeout_s=3.0):
+    """
+    Download a lookup table to the sensor and wait until it is active.
+
+    Args:
+        sensor: Sensor instance connected to the bridge
+        positions: Table keys (mm), strictly increasing
+        distances: Table values (mm)
+        timeout_s: Time to wait for the sensor to acknowledge BEGIN and to
+            report the new table
+
+    Returns:
+        True if the sensor reports the table active with a matching CRC
+    """
+    frames, crc = build_frames(positions, distances)
+    begin_frame, data_frames, commit_frame = frames[0], frames[1:-1], frames[-1]
+
+    if not _begin(sensor, begin_frame, timeout_s):
+        return False
+    if not _send_words(sensor, data_frames):
+        return False
+
+    for _ in range(LUT_DOWNLOAD_RETRIES):
+        _send_paced(sensor, *commit_frame)
+        deadline = time.time() + timeout_s
+        while time.time() < deadline:
+            payload = _wait_for(sensor, LUT_STATUS_FRAME, deadline - time.time())
+            if payload is None:
+                break
+            status = parse_status(payload)
+            # Checked first: a resent COMMIT after the swap fails with SEQUENCE
+            if status['active_crc'] == crc and status['active_size'] == len(positions):
+                print(f"[LUT] Download active: {len(positions)} entries, CRC 0x{crc:08X}")
+                return True
+            if status['state'] == "FAILED":
+                print(f"[LUT] Download rejected: {status['error']}")
+                return False
+
+    print("[LUT] Download timed out waiting for the sensor")
+    return False
@@ -0,0 +1,198 @@
+// Measure Pipeline
+// Single or double-buffered sensor reads with frame timing, see
+// measure_pipeline.h.
+
+#include "measure_pipeline.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "acc_hal_integration_a121.h"
+#include "can_tx_queue.h"
+#include "main.h"
+
+static void timer_enable(void)
+{
+#ifdef DWT
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+// Cycles with a DWT, milliseconds without
+static uint32_t timestamp(void)
+{
+#ifdef DWT
+        return DWT->CYCCNT;
+#else
+        return HAL_GetTick();
+#endif
+}
+
+static uint32_t elapsed_us(uint32_t since)
+{
+#ifdef DWT
+        return (DWT->CYCCNT - since) / (SystemCoreClock / 1000000U);
+#else
+        return (HAL_GetTick() - since) * 1000U;
+#endif
+}
+
+static void timer_clear(MeasureTimer *timer)
+{
+        timer->sum_us = 0;
+        timer->max_us = 0;
+        timer->min_us = UINT32_MAX;
+}
+
+static void timer_add(MeasureTimer *timer, uint32_t us)
+{
+        timer->sum_us += us;
+        timer->max_us = (us > timer->max_us) ? us : timer->max_us;
+        timer->min_us = (us < timer->min_us) ? us : timer->min_us;
+}
+
+static uint16_t saturate_us(uint32_t us)
+{
+        return (us > UINT16_MAX) ? UINT16_MAX : (uint16_t)us;
+}
+
+static void send_timer(uint8_t timer_id, const MeasureTimer *timer, uint16_t count)
+{
+        uint16_t avg = saturate_us(timer->sum_us / count);
+        uint16_t max = saturate_us(timer->max_us);
+        uint16_t min = saturate_us(timer->min_us);
+        uint8_t  data[8];
+
+        data[0] = timer_id;
+        data[1] = (avg >> 8) & 0xFF;
+        data[2] = avg & 0xFF;
+        data[3] = (max >> 8) & 0xFF;
+        data[4] = max & 0xFF;
+        data[5] = (min >> 8) & 0xFF;
+        data[6] = min & 0xFF;
+        data[7] = (count > UINT8_MAX) ? UINT8_MAX : (uint8_t)count;
+
+        can_tx_queue_send(MEASURE_PIPELINE_CAN_TIMING, data);
+}
+
+static void record_frame(MeasurePipeline *pipeline, uint32_t wait_us)
+{
+        // The first frame after init or idle has no period
+        if (pipeline->started)
+        {
+                timer_add(&pipeline->period, elapsed_us(pipeline->last_frame));
+                timer_add(&pipeline->wait, wait_us);
+                pipeline->frames++;
+        }
+        pipeline->last_frame = timestamp();
+        pipeline->started    = true;
+
+        if (pipeline->frames >= MEASURE_PIPELINE_REPORT_FRAMES)
+        {
+                send_timer(MEASURE_PIPELINE_TIMER_FRAME_PERIOD, &pipeline->period, pipeline->frames);
+                send_timer(MEASURE_PIPELINE_TIMER_SENSOR_WAIT, &pipeline->wait, pipeline->frames);
+
+                pipeline->frames = 0;
+                timer_clear(&pipeline->period);
+                timer_clear(&pipeline->wait);
+        }
+}
+
+static bool start_measurement(MeasurePipeline *pipeline)
+{
+        if (!acc_sensor_measure(pipeline->sensor))
+        {
+                printf("acc_sensor_measure failed\n");
+                return false;
+        }
+        pipeline->in_flight = true;
+        return true;
+}
+
+static bool read_measurement(MeasurePipeline *pipeline, void *buffer)
+{
+        if (!acc_hal_integration_wait_for_sensor_interrupt(pipeline->sensor_id, pipeline->timeout_ms))
+        {
+                printf("Sensor interrupt timeout\n");
+                return false;
+        }
+
+        if (!acc_sensor_read(pipeline->sensor, buffer, pipeline->buffer_size))
+        {
+                printf("acc_sensor_read failed\n");
+                return false;
+        }
+        pipeline->in_flight = false;
+        return true;
+}
+
+uint32_t measure_pipeline_alloc_size(uint32_t buffer_size)
+{
+#ifdef PIPELINED_MEASUREMENT
+        return 2U * ((buffer_size + 7U) & ~7U);
+#else
+        return buffer_size;
+#endif
+}
+
+void measure_pipeline_init(MeasurePipeline *pipeline, acc_sensor_t *sensor, acc_sensor_id_t sensor_id,
+                           uint32_t timeout_ms, void *buffer, uint32_t buffer_size)
+{
+        memset(pipeline, 0, sizeof(*pipeline));
+        pipeline->sensor      = sensor;
+        pipeline->sensor_id   = sensor_id;
+        pipeline->timeout_ms  = timeout_ms;
+        pipeline->buffer_size = buffer_size;
+        pipeline->buffers[0]  = buffer;
+#ifdef PIPELINED_MEASUREMENT
+        pipeline->buffers[1] = (uint8_t *)buffer + ((buffer_size + 7U) & ~7U);
+#else
+        pipeline->buffers[1] = buffer;
+#endif
+        timer_clear(&pipeline->period);
+        timer_clear(&pipeline->wait);
+        timer_enable();
+}
+
+bool measure_pipeline_next(MeasurePipeline *pipeline, void **frame_buffer)
+{
+        uint32_t start = timestamp();
+        void     *buffer = pipeline->buffers[pipeline->next];
+
+        if (!pipeline->in_flight && !start_measurement(pipeline))
+        {
+                return false;
+        }
+
+        if (!read_measurement(pipeline, buffer))
+        {
+                return false;
+        }
+
+#ifdef PIPELINED_MEASUREMENT
+        // Acquire the next frame while the caller works on this one
+        if (!start_measurement(pipeline))
+        {
+                return false;
+        }
+        pipeline->next ^= 1U;
+#endif
+
+        record_frame(pipeline, elapsed_us(start));
+        *frame_buffer = buffer;
+        return true;
+}
+
+bool measure_pipeline_idle(MeasurePipeline *pipeline)
+{
+        pipeline->started = false;
+
+        if (!pipeline->in_flight)
+        {
+                return true;
+        }
+
+        // Read into the buffer that is not handed out, so the caller's frame survives
+        return read_measurement(pipeline, pipeline->buffers[pipeline->next]);
+}
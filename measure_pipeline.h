@@ -0,0 +1,86 @@
+// Measure Pipeline
+// Hands acc_service() one frame read from the sensor per call.
+//
+// Without PIPELINED_MEASUREMENT each call is measure, wait for the interrupt,
+// read, as before. With it the next measurement is triggered as soon as a
+// frame has been read, into the other half of a double buffer, so the sensor
+// acquires frame N+1 while frame N is processed, run through the detector and
+// sent over CAN. The frame handed out stays valid until the next call.
+//
+// Anything that calibrates or prepares the sensor again must first call
+// measure_pipeline_idle(), which waits for the measurement in flight and
+// drops it: it was taken with the old settings. The next call then starts a
+// new measurement.
+//
+// Frame timing is sent every MEASURE_PIPELINE_REPORT_FRAMES frames in the
+// 0x700 performance timing format (classic CAN, big-endian), timer ids after
+// the ones the host already knows:
+//   0x700 PERF TIMING  sensor -> host  timer id (u8), avg us (u16), max us (u16),
+//                                      min us (u16), count (u8)
+//     12 FRAME_PERIOD  from one frame handed out to the next; 1e6 / avg is the
+//                      achievable frame rate
+//     13 SENSOR_WAIT   time of that spent waiting for the sensor
+// Times come from the DWT cycle counter where the core has one, HAL_GetTick()
+// otherwise, and saturate at 65535 us.
+
+#ifndef MEASURE_PIPELINE_H
+#define MEASURE_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_definitions_a121.h"
+#include "acc_sensor.h"
+
+#define MEASURE_PIPELINE_CAN_TIMING (0x700U)
+
+#define MEASURE_PIPELINE_TIMER_FRAME_PERIOD (12U)
+#define MEASURE_PIPELINE_TIMER_SENSOR_WAIT  (13U)
+
+#ifndef MEASURE_PIPELINE_REPORT_FRAMES
+#define MEASURE_PIPELINE_REPORT_FRAMES (50U)
+#endif
+
+typedef struct
+{
+        uint32_t sum_us;
+        uint32_t max_us;
+        uint32_t min_us;
+} MeasureTimer;
+
+typedef struct
+{
+        acc_sensor_t    *sensor;
+        acc_sensor_id_t sensor_id;
+        uint32_t        timeout_ms;
+        void            *buffers[2];
+        uint32_t        buffer_size;
+        uint8_t         next;      // Buffer the next frame is read into
+        bool            in_flight; // A measurement was triggered and not read yet
+
+        // Timing since the last report
+        bool            started;
+        uint32_t        last_frame; // Timestamp of the last frame handed out
+        uint16_t        frames;
+        MeasureTimer    period;
+        MeasureTimer    wait;
+} MeasurePipeline;
+
+// Bytes to allocate for a sensor buffer of buffer_size: two buffers when
+// pipelined, each kept 8-byte aligned
+uint32_t measure_pipeline_alloc_size(uint32_t buffer_size);
+
+// buffer is the allocation sized by measure_pipeline_alloc_size(); its first
+// buffer_size bytes are also the buffer for calibration and prepare
+void measure_pipeline_init(MeasurePipeline *pipeline, acc_sensor_t *sensor, acc_sensor_id_t sensor_id,
+                           uint32_t timeout_ms, void *buffer, uint32_t buffer_size);
+
+// Read the next frame into *frame_buffer, triggering the one after it when
+// pipelined. Prints and returns false on a sensor error.
+bool measure_pipeline_next(MeasurePipeline *pipeline, void **frame_buffer);
+
+// Wait for and drop a measurement in flight. Prints and returns false on a
+// sensor error.
+bool measure_pipeline_idle(MeasurePipeline *pipeline);
+
+#endif // MEASURE_PIPELINE_H
@@ -0,0 +1,162 @@
+// Power Kernel
+// Scalar, Cortex-M DSP and x86 SSE2/AVX2 squared-magnitude loops, see
+// power_kernel.h.
+
+#include "power_kernel.h"
+
+#include <string.h>
+
+// Bins integrated per pass in power_kernel_integrate()
+#define POWER_KERNEL_BLOCK (32U)
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POWER_KERNEL_X86 1
+#elif defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "main.h" // CMSIS __SMUAD()
+#define POWER_KERNEL_ARM_DSP 1
+#endif
+
+void power_kernel_scalar(const acc_int16_complex_t *data, uint32_t *power, uint16_t count)
+{
+        for (uint16_t i = 0; i < count; i++)
+        {
+                power[i] = (uint32_t)(data[i].real * data[i].real) + (uint32_t)(data[i].imag * data[i].imag);
+        }
+}
+
+#ifdef POWER_KERNEL_ARM_DSP
+
+// One sample is one 32-bit word holding both halves, so SMUAD(w, w) is
+// re*re + im*im in a single cycle
+static void power_kernel_dsp(const acc_int16_complex_t *data, uint32_t *power, uint16_t count)
+{
+        uint16_t i = 0;
+
+        for (; i + 2 <= count; i += 2)
+        {
+                uint32_t w0;
+                uint32_t w1;
+
+                memcpy(&w0, &data[i], sizeof(w0));
+                memcpy(&w1, &data[i + 1], sizeof(w1));
+                power[i]     = __SMUAD(w0, w0);
+                power[i + 1] = __SMUAD(w1, w1);
+        }
+
+        for (; i < count; i++)
+        {
+                uint32_t w;
+
+                memcpy(&w, &data[i], sizeof(w));
+                power[i] = __SMUAD(w, w);
+        }
+}
+
+#endif
+
+#ifdef POWER_KERNEL_X86
+
+// PMADDWD multiplies the int16 lanes and adds adjacent pairs, which for
+// interleaved I/Q is re*re + im*im per 32-bit lane
+__attribute__((target("avx2")))
+static void power_kernel_avx2(const acc_int16_complex_t *data, uint32_t *power, uint16_t count)
+{
+        uint16_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+                __m256i iq = _mm256_loadu_si256((const __m256i *)&data[i]);
+                _mm256_storeu_si256((__m256i *)&power[i], _mm256_madd_epi16(iq, iq));
+        }
+
+        power_kernel_scalar(&data[i], &power[i], count - i);
+}
+
+__attribute__((target("sse2")))
+static void power_kernel_sse2(const acc_int16_complex_t *data, uint32_t *power, uint16_t count)
+{
+        uint16_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+                __m128i iq = _mm_loadu_si128((const __m128i *)&data[i]);
+                _mm_storeu_si128((__m128i *)&power[i], _mm_madd_epi16(iq, iq));
+        }
+
+        power_kernel_scalar(&data[i], &power[i], count - i);
+}
+
+#endif
+
+#ifdef POWER_KERNEL_X86
+
+typedef void (*power_kernel_fn)(const acc_int16_complex_t *data, uint32_t *power, uint16_t count);
+
+// Resolved on the first call, so the CPU feature checks stay out of the per-call path
+static power_kernel_fn x86_kernel = NULL;
+
+static power_kernel_fn select_x86_kernel(void)
+{
+        if (__builtin_cpu_supports("avx2"))
+        {
+                return power_kernel_avx2;
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+                return power_kernel_sse2;
+        }
+        return power_kernel_scalar;
+}
+
+#endif
+
+void power_kernel(const acc_int16_complex_t *data, uint32_t *power, uint16_t count)
+{
+#if defined(POWER_KERNEL_ARM_DSP)
+        power_kernel_dsp(data, power, count);
+#elif defined(POWER_KERNEL_X86)
+        if (x86_kernel == NULL)
+        {
+                x86_kernel = select_x86_kernel();
+        }
+        x86_kernel(data, power, count);
+#else
+        power_kernel_scalar(data, power, count);
+#endif
+}
+
+void power_kernel_integrate(const acc_int16_complex_t *data, uint16_t stride, uint16_t sweeps,
+                            uint32_t *power, uint16_t count)
+{
+        if (sweeps <= 1)
+        {
+                power_kernel(data, power, count);
+                return;
+        }
+
+        // Bin blocks outermost so the sums stay in registers/L1 while every sweep streams past
+        for (uint16_t block = 0; block < count; block += POWER_KERNEL_BLOCK)
+        {
+                uint16_t n = count - block;
+                n = (n > POWER_KERNEL_BLOCK) ? POWER_KERNEL_BLOCK : n;
+
+                uint64_t sum[POWER_KERNEL_BLOCK] = { 0 };
+                uint32_t sweep_power[POWER_KERNEL_BLOCK];
+
+                for (uint32_t s = 0; s < sweeps; s++)
+                {
+                        power_kernel(&data[s * stride + block], sweep_power, n);
+                        for (uint16_t j = 0; j < n; j++)
+                        {
+                                sum[j] += sweep_power[j];
+                        }
+                }
+
+                // No divide by sweeps: callers fold it into their thresholds and scale
+                for (uint16_t j = 0; j < n; j++)
+                {
+                        power[block + j] = (sum[j] > UINT32_MAX) ? UINT32_MAX : (uint32_t)sum[j];
+                }
+        }
+}
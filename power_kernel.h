@@ -0,0 +1,36 @@
+// Power Kernel
+// Squared magnitude (re^2 + im^2) of interleaved int16 I/Q samples into uint32
+// power, the inner loop of the threshold detectors.
+//
+// power_kernel() picks the fastest path for the target:
+//   Cortex-M with the DSP extension  one SMUAD per bin (dual 16-bit MAC)
+//   x86 host replay builds           AVX2 (8 bins) or SSE2 (4 bins) PMADDWD,
+//                                    chosen at runtime
+//   anything else                    power_kernel_scalar()
+//
+// Every path returns exactly what power_kernel_scalar() does, including
+// re = im = -32768 (2^31, which wraps the signed multiply-add but not uint32).
+
+#ifndef POWER_KERNEL_H
+#define POWER_KERNEL_H
+
+#include <stdint.h>
+
+#include "acc_definitions_common.h"
+
+// Reference implementation
+void power_kernel_scalar(const acc_int16_complex_t *data, uint32_t *power, uint16_t count);
+
+void power_kernel(const acc_int16_complex_t *data, uint32_t *power, uint16_t count);
+
+// Non-coherent integration over the sweeps of a frame: power[j] is the sum of
+// the power of data[s * stride + j] over s = 0..sweeps-1, saturating at
+// UINT32_MAX. It is not divided by sweeps, which would be a 64-bit library
+// divide per bin on the Cortex-M: detection_plan_set_divisor() scales the
+// limits by sweeps instead, the CA-CFAR ratio does not depend on it, and
+// callers turn the few powers they report into amplitudes by dividing by
+// divisor * sweeps once. sweeps = 1 is exactly power_kernel().
+void power_kernel_integrate(const acc_int16_complex_t *data, uint16_t stride, uint16_t sweeps,
+                            uint32_t *power, uint16_t count);
+
+#endif // POWER_KERNEL_H
@@ -0,0 +1,174 @@
+// Power Kernel Benchmark
+// Host cross-check and benchmark of the power_kernel.c paths. Every path the
+// CPU supports is checked bit-exact against power_kernel_scalar() on random
+// int16 I/Q (including the -32768 / 32767 extremes) for every count up to
+// 70, then timed on a 400-bin sweep. Exits non-zero on a mismatch.
+//
+// The Cortex-M DSP path only builds for the target and is not covered here.
+//
+// Build and run (the include path is the Acconeer RSS include directory):
+//   gcc -O2 -I<rss>/include power_kernel_bench.c -o power_kernel_bench && ./power_kernel_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// The SIMD paths are static; build them into this file
+#include "power_kernel.c"
+
+#define BENCH_BINS       (400U)
+#define BENCH_CHECK_MAX  (70U)
+#define BENCH_ITERATIONS (200000U)
+
+typedef struct
+{
+        const char *name;
+        void (*run)(const acc_int16_complex_t *data, uint32_t *power, uint16_t count);
+        int supported;
+} bench_path_t;
+
+static int16_t random_i16(void)
+{
+        // One sample in 16 at an extreme, where the signed multiply-add wraps
+        switch (rand() % 16)
+        {
+                case 0:  return INT16_MIN;
+                case 1:  return INT16_MAX;
+                default: return (int16_t)((rand() & 0xFFFF) - 0x8000);
+        }
+}
+
+static double now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int check_path(const bench_path_t *path, const acc_int16_complex_t *data)
+{
+        uint32_t expected[BENCH_CHECK_MAX];
+        uint32_t actual[BENCH_CHECK_MAX];
+
+        for (uint16_t count = 0; count <= BENCH_CHECK_MAX; count++)
+        {
+                // Shifted starts so the unaligned loads and the scalar tails are both exercised
+                for (uint16_t offset = 0; offset < 3; offset++)
+                {
+                        uint16_t n = (count > BENCH_CHECK_MAX - offset) ? BENCH_CHECK_MAX - offset : count;
+
+                        power_kernel_scalar(&data[offset], expected, n);
+                        path->run(&data[offset], actual, n);
+                        if (memcmp(expected, actual, n * sizeof(uint32_t)) != 0)
+                        {
+                                printf("%s: mismatch at count %u, offset %u\n", path->name, (unsigned)n,
+                                       (unsigned)offset);
+                                return 1;
+                        }
+                }
+        }
+
+        return 0;
+}
+
+static int check_integrate(const acc_int16_complex_t *data)
+{
+        const uint16_t sweeps = 4;
+        const uint16_t count  = 67;
+        uint32_t       power[67];
+
+        power_kernel_integrate(data, count, sweeps, power, count);
+        for (uint16_t j = 0; j < count; j++)
+        {
+                uint64_t sum = 0;
+
+                for (uint16_t s = 0; s < sweeps; s++)
+                {
+                        uint32_t p;
+
+                        power_kernel_scalar(&data[s * count + j], &p, 1);
+                        sum += p;
+                }
+                if (power[j] != ((sum > UINT32_MAX) ? UINT32_MAX : (uint32_t)sum))
+                {
+                        printf("power_kernel_integrate: mismatch at bin %u\n", (unsigned)j);
+                        return 1;
+                }
+        }
+
+        return 0;
+}
+
+static void bench(const bench_path_t *path, const acc_int16_complex_t *data, uint32_t *power)
+{
+        volatile uint32_t sink = 0;
+        uint64_t          ticks;
+        double            start = now_ns();
+        uint64_t          start_ticks = __rdtsc();
+
+        for (uint32_t k = 0; k < BENCH_ITERATIONS; k++)
+        {
+                path->run(data, power, BENCH_BINS);
+                sink += power[k % BENCH_BINS];
+        }
+
+        ticks = __rdtsc() - start_ticks;
+        double ns = now_ns() - start;
+        double bins = (double)BENCH_ITERATIONS * BENCH_BINS;
+
+        (void)sink;
+        printf("%-8s %10.3f %14.3f %14.1f\n", path->name, (double)ticks / bins, ns / bins,
+               ns / BENCH_ITERATIONS);
+}
+
+int main(void)
+{
+        static acc_int16_complex_t data[BENCH_BINS * 4];
+        static uint32_t            power[BENCH_BINS];
+        int                        failed = 0;
+
+        const bench_path_t paths[] = {
+                { "scalar",  power_kernel_scalar, 1 },
+                { "sse2",    power_kernel_sse2,   __builtin_cpu_supports("sse2") },
+                { "avx2",    power_kernel_avx2,   __builtin_cpu_supports("avx2") },
+                { "dispatch", power_kernel,       1 },
+        };
+
+        srand(1);
+        for (uint32_t i = 0; i < BENCH_BINS * 4; i++)
+        {
+                data[i].real = random_i16();
+                data[i].imag = random_i16();
+        }
+
+        for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); p++)
+        {
+                if (paths[p].supported)
+                {
+                        failed |= check_path(&paths[p], data);
+                }
+        }
+        failed |= check_integrate(data);
+
+        printf("%-8s %10s %14s %14s\n", "path", "tsc/bin", "ns/bin", "ns/400 bins");
+        for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); p++)
+        {
+                if (paths[p].supported)
+                {
+                        bench(&paths[p], data, power);
+                }
+                else
+                {
+                        printf("%-8s not supported by this CPU\n", paths[p].name);
+                }
+        }
+
+        if (failed)
+        {
+                printf("FAILED: a path disagrees with power_kernel_scalar()\n");
+                return EXIT_FAILURE;
+        }
+        printf("All paths match power_kernel_scalar()\n");
+        return EXIT_SUCCESS;
+}
@@ -66,6 +66,18 @@ class Sensor:
 
         return t, bytes(payload)
 
+    def write_frame(self, frame_type, payload):
+        """Write one framed message: [0x7E][type][len][payload...][chk]"""
+        chk = frame_type ^ len(payload)
+        for pb in payload:
+            chk ^= pb
+        self.ser.write(bytes([0x7E, frame_type, len(payload)]) + bytes(payload) + bytes([chk]))
+
+    def send_can(self, can_id, data):
+        """Ask the bridge to transmit a classic CAN frame (type 0xC1: id(2) | data(8))"""
+        payload = struct.pack('>H', can_id) + bytes(data).ljust(8, b'\x00')
+        self.write_frame(0xC1, payload)
+
     def get_current_distance(self, timeout_s=0.2):
         """Convenience wrapper: return telemetry frame if available.
 
@@ -78,7 +90,7 @@ class Sensor:
         if t == 0x10 and payload and len(payload) >= 10:
             # distance (4), temp (2), encoder (4) -- big-endian
             distance_raw = struct.unpack('>I', payload[0:4])[0]
-            temp_raw = struct.unpack('>H', payload[4:6])[0]
+            temp_raw = struct.unpack('>h', payload[4:6])[0]  # signed degrees C
             encoder_raw = int.from_bytes(payload[6:10], byteorder='big', signed=True)
             package_recieved_time = time.time()
             # keep compatibility with previous scaling
@@ -8,8 +8,11 @@ import numpy as np
 import openpyxl
 import matplotlib.pyplot as plt
 import struct
+from deferred_log import DeferredLogDecoder, DEFERRED_LOG_FRAME
 import json
 from tkinter import Tk, filedialog
+from lut_batch import BatchCorrector, inverse_table
+from lut_download import upload_lookup_table, parse_status, LUT_STATUS_FRAME
 
 class SensorComparison:
     def __init__(self):
@@ -17,6 +20,7 @@ class SensorComparison:
         
         # Lookup table for distance correction
         self.lookup_table = None
+        self.lut_corrector = None
         self.lut_loaded = False
         
         # ===== CONFIGURATION =====
@@ -39,6 +43,9 @@ class SensorComparison:
         self.template_filepath = os.path.join(dir_name, "template_senor_comp_v4.xlsx")
         self.excel_filepath = dir_name + f"/TDS_{time_string}.xlsx"
 
+        # Message table for the sensor's deferred log, from the firmware header
+        self.log_decoder = DeferredLogDecoder(os.path.join(dir_name, "deferred_log.h"))
+
         self.sensor_distances = []
         self.sensor_timestamps = []
         self.linear_encoder_positions = []  # Generic position sensor data (encoder or string pot)
@@ -96,6 +103,8 @@ class SensorComparison:
         # TIMER_THRESHOLD_CHECK,              // Threshold checking
         # TIMER_INTERPOLATION,                // Linear interpolation
         # TIMER_LUT_LOOKUP,                   // Lookup table correction
+        # FRAME_PERIOD = 12,                  // Frame to frame, 1e6 / avg = frame rate
+        # SENSOR_WAIT,                        // Part of the period waiting for the sensor
         
         # TIMER_COUNT                         
             0: "SENSOR_MEASURE",
@@ -110,19 +119,29 @@ class SensorComparison:
             9: "THRESHOLD_CHECK",
             10: "INTERPOLATION",
             11: "LUT_LOOKUP",
+            12: "FRAME_PERIOD",
+            13: "SENSOR_WAIT",
         }
         
         self.performance_data = {timer_id: {'avg': [], 'max': [], 'min': [], 'timestamps': []} 
-                                  for timer_id in range(12)}
+                                  for timer_id in self.timer_names}
 
         self.wb = openpyxl.load_workbook(self.template_filepath)
         self.ws = self.wb["RAW_DATA"]
 
         # Temporary storage to correlate diagnostic frames
         self._pending_diag = {}
+        # Last CAN FD telemetry sequence number, to count dropped frames
+        self._last_sequence = None
+        # Last CAN FD burst sequence number, to count dropped bursts
+        self._last_burst = None
 
         self.init_instruments()
         
+        # Offer to download the loaded table into the sensor's RAM bank
+        if self.lut_loaded:
+            self.upload_lookup_table_prompt()
+        
         # Print session information
         print(f"\n{'='*60}")
         print(f"SENSOR COMPARISON TOOL - Session Started")
@@ -165,6 +184,9 @@ class SensorComparison:
                     'distances': data['compiled_distances'],
                     'metadata': data.get('metadata', {})
                 }
+                # Reverse lookup (distance -> position) over the sorted, de-duplicated inverse table
+                self.lut_corrector = BatchCorrector(*inverse_table(data['compiled_distances'],
+                                                                   data['compiled_positions']))
                 self.lut_loaded = True
                 print(f"\n[LUT] Loaded: {self.lookup_table['name']}")
                 print(f"[LUT] Entries: {len(self.lookup_table['positions'])}")
@@ -174,31 +196,24 @@ class SensorComparison:
         except Exception as e:
             print(f"[LUT] Error loading lookup table: {str(e)}")
     
+    def upload_lookup_table_prompt(self):
+        """Prompt user to download the loaded lookup table to the sensor over CAN"""
+        print("Download this lookup table to the sensor over CAN? (y/n): ", end='')
+        if input().strip().lower() != 'y':
+            return
+        
+        try:
+            upload_lookup_table(self.sensor, self.lookup_table['positions'], self.lookup_table['distances'])
+        except ValueError as e:
+            print(f"[LUT] Cannot download lookup table: {str(e)}")
+    
     def apply_lookup_table(self, sensor_distance):
         """Apply lookup table correction to get true position from sensor distance"""
         if not self.lut_loaded or not self.lookup_table:
             return None
         
-        positions = self.lookup_table['positions']
-        distances = self.lookup_table['distances']
-        
-        # Handle edge cases
-        if sensor_distance <= min(distances):
-            idx = distances.index(min(distances))
-            return positions[idx]
-        if sensor_distance >= max(distances):
-            idx = distances.index(max(distances))
-            return positions[idx]
-        
-        # Linear interpolation
-        for i in range(len(distances) - 1):
-            d1, d2 = distances[i], distances[i + 1]
-            if (d1 <= sensor_distance <= d2) or (d2 <= sensor_distance <= d1):
-                p1, p2 = positions[i], positions[i + 1]
-                if d2 != d1:
-                    return p1 + (p2 - p1) * (sensor_distance - d1) / (d2 - d1)
-        
-        return None
+        # One sample per frame: the pure-Python search beats a ctypes round trip
+        return self.lut_corrector.correct_one(sensor_distance)
 
     def get_error_name(self, error_code):
         """Convert error code to human-readable name"""
@@ -221,6 +236,27 @@ class SensorComparison:
         
         print(f"[DIAGNOSTIC] Error detected: {self.get_error_name(error_code)} (Code {error_code}), Count: {error_count}")
 
+    def log_fd_telemetry(self, fd):
+        """Check the sequence and print the fields of a 0x15 CAN FD telemetry payload"""
+        (_, divisor, _, max_amplitude, first_threshold_y, raw_distance,
+         first_threshold_x, sequence, timestamp_ms) = struct.unpack('>IHHIIIIII', fd)
+        if self._last_sequence is not None and sequence != (self._last_sequence + 1) & 0xFFFFFFFF:
+            dropped = (sequence - self._last_sequence - 1) & 0xFFFFFFFF
+            print(f"[FD] {dropped} telemetry frame(s) dropped before #{sequence}")
+        self._last_sequence = sequence
+        print(f"[FD] #{sequence} t={timestamp_ms}ms Raw: {raw_distance / 10.0:.2f}mm MaxAmp: {max_amplitude} "
+              f"FirstY: {first_threshold_y} FirstX: {first_threshold_x / 10.0:.2f}mm Divisor: {divisor}")
+
+    def log_burst_sample(self, info):
+        """Check the burst sequence of one unpacked 0x16 CAN FD burst sample"""
+        tick_ms, burst, index, count = struct.unpack('>IHBB', info)
+        if index == 0:
+            if self._last_burst is not None and burst != (self._last_burst + 1) & 0xFFFF:
+                dropped = (burst - self._last_burst - 1) & 0xFFFF
+                print(f"[BURST] {dropped} burst(s) dropped before #{burst}")
+            self._last_burst = burst
+        print(f"[BURST] #{burst} sample {index + 1}/{count} t={tick_ms}ms")
+
     def get_data(self):
         # Read any available frame and handle telemetry or diagnostic frames
         frame_type, payload = self.sensor.read_frame(timeout_s=0.05)
@@ -229,9 +265,10 @@ class SensorComparison:
 
         ts = time.time()
         # Telemetry distance frame (type 0x10): distance(4)|temp(2)|encoder(4)|distanceOutput(4)
-        if frame_type == 0x10 and payload and len(payload) >= 14:
+        # CAN FD telemetry (type 0x12) and burst samples (type 0x13) start with the same 14 bytes
+        if frame_type in (0x10, 0x12, 0x13) and payload and len(payload) >= 14:
             distance_raw = struct.unpack('>I', payload[0:4])[0]
-            temp_raw = struct.unpack('>H', payload[4:6])[0]
+            temp_raw = struct.unpack('>h', payload[4:6])[0]  # signed degrees C, as the firmware uses it
             encoder_raw = int.from_bytes(payload[6:10], byteorder='big', signed=True)
             distance_output_raw = int.from_bytes(payload[10:14], byteorder='big', signed=True)
 
@@ -276,6 +313,11 @@ class SensorComparison:
             self.write2file([distance, temp, linec, measurement_delta, distance_output, distance_output_delta, stringpot_vs_distout_delta, 
                            corrected_distance if corrected_distance is not None else distance, corrected_delta, ts])
 
+            if frame_type == 0x12 and len(payload) >= 14 + 32:
+                self.log_fd_telemetry(payload[14:14 + 32])
+            elif frame_type == 0x13 and len(payload) >= 14 + 8:
+                self.log_burst_sample(payload[14:14 + 8])
+
         # Amplitude telemetry (type 0x11) - currently ignored but could be stored
         elif frame_type == 0x11 and payload and len(payload) >= 8:
             # optional: parse and log amplitude
@@ -320,6 +362,20 @@ class SensorComparison:
             self.error_history.extend([e1, e2, e3, e4])
             print(f"[DIAG] ErrorHistory Chunk {chunk}: [{e1},{e2},{e3},{e4}]")
 
+        elif frame_type == 0xA4 and payload and len(payload) >= 8:
+            # tracking gate stats since the last report
+            hits, misses, full_scans, bins_per_frame = struct.unpack('>HHHH', payload[0:8])
+            print(f"[GATE] Hits: {hits} Misses: {misses} FullScans: {full_scans} Bins/frame: {bins_per_frame}")
+
+        elif frame_type == 0xA5 and payload and len(payload) >= 8:
+            # CAN TX queue stats since the last report
+            queued, overflows, hal_errors, high_water, size = struct.unpack('>HHHBB', payload[0:8])
+            print(f"[CANTX] Queued: {queued} Overflows: {overflows} HalErrors: {hal_errors} HighWater: {high_water}/{size}")
+
+        elif frame_type == DEFERRED_LOG_FRAME and payload and len(payload) >= 8:
+            # deferred log message, text from the table in deferred_log.h
+            print(f"[LOG] {self.log_decoder.decode(payload)}")
+
         # Performance timing data (type 0xB0)
         elif frame_type == 0xB0 and payload and len(payload) >= 8:
             timer_id = payload[0]
@@ -328,7 +384,7 @@ class SensorComparison:
             min_us = (payload[5] << 8) | payload[6]
             count = payload[7]
             
-            if timer_id < 12:
+            if timer_id in self.performance_data:
                 self.performance_data[timer_id]['avg'].append(avg_us)
                 self.performance_data[timer_id]['max'].append(max_us)
                 self.performance_data[timer_id]['min'].append(min_us)
@@ -337,6 +393,12 @@ class SensorComparison:
                 timer_name = self.timer_names.get(timer_id, f"UNKNOWN_{timer_id}")
                 print(f"[PERF] {timer_name}: avg={avg_us}us, max={max_us}us, min={min_us}us, count={count}")
 
+        # Lookup table download status (type 0xC0)
+        elif frame_type == LUT_STATUS_FRAME and payload and len(payload) >= 8:
+            status = parse_status(payload)
+            print(f"[LUT] Sensor download state: {status['state']} ({status['error']}), "
+                  f"active: {status['active_size']} entries, CRC 0x{status['active_crc']:08X}")
+
         else:
             # unknown or unhandled frame types
             pass
@@ -460,7 +522,7 @@ class SensorComparison:
     def plot_performance_timing(self):
         """Plot performance timing data for all timers"""
         # Check if any performance data was collected
-        has_data = any(len(self.performance_data[tid]['avg']) > 0 for tid in range(12))
+        has_data = any(len(self.performance_data[tid]['avg']) > 0 for tid in self.timer_names)
         if not has_data:
             print("No performance timing data collected for plotting.")
             return
@@ -531,7 +593,7 @@ class SensorComparison:
         max_times = []
         min_times = []
         
-        for timer_id in range(12):
+        for timer_id in self.timer_names:
             if len(self.performance_data[timer_id]['avg']) > 0:
                 timer_labels.append(self.timer_names[timer_id])
                 avg_times.append(np.mean(self.performance_data[timer_id]['avg']))
@@ -563,6 +625,10 @@ class SensorComparison:
             print("="*60)
             for i, label in enumerate(timer_labels):
                 print(f"{label:25} Min: {min_times[i]:8.2f}μs  Avg: {avg_times[i]:8.2f}μs  Max: {max_times[i]:8.2f}μs")
+            if "FRAME_PERIOD" in timer_labels:
+                period = avg_times[timer_labels.index("FRAME_PERIOD")]
+                if period > 0:
+                    print(f"{'Achievable frame rate':25} {1e6 / period:8.1f} Hz")
             print("="*60 + "\n")
 
     def create_lookup_table(self):
@@ -629,103 +695,109 @@ class SensorComparison:
                 h_file.write("    {:.2f}f{}\n".format(dist, comma))
             h_file.write("};\n\n")
             
+            # Inverse table: sorted by distance with duplicate distances averaged, so
+            # reverse lookups stay searchable when the sensor error is not monotonic
+            inverse_lookup = {}
+            for pos in sorted_positions:
+                dist_rounded = round(averaged_lookup[pos], 2)
+                if dist_rounded in inverse_lookup:
+                    inverse_lookup[dist_rounded].append(pos)
+                else:
+                    inverse_lookup[dist_rounded] = [pos]
+            inverse_distances = sorted(inverse_lookup.keys())
+            
+            h_file.write("// Inverse table size (distances sorted, duplicates averaged)\n")
+            h_file.write("#define INVERSE_TABLE_SIZE {}\n".format(len(inverse_distances)))
+            h_file.write("#define INVERSE_DISTANCE_MIN {:.2f}f\n".format(inverse_distances[0]))
+            h_file.write("#define INVERSE_DISTANCE_MAX {:.2f}f\n\n".format(inverse_distances[-1]))
+            
+            h_file.write("// Inverse distance array (mm), strictly increasing\n")
+            h_file.write("const float inverse_distances[INVERSE_TABLE_SIZE] = {\n")
+            for i, dist in enumerate(inverse_distances):
+                comma = "," if i < len(inverse_distances) - 1 else ""
+                h_file.write("    {:.2f}f{}\n".format(dist, comma))
+            h_file.write("};\n\n")
+            
+            h_file.write("// Inverse position array (mm)\n")
+            h_file.write("const float inverse_positions[INVERSE_TABLE_SIZE] = {\n")
+            for i, dist in enumerate(inverse_distances):
+                pos = sum(inverse_lookup[dist]) / len(inverse_lookup[dist])
+                comma = "," if i < len(inverse_distances) - 1 else ""
+                h_file.write("    {:.2f}f{}\n".format(pos, comma))
+            h_file.write("};\n\n")
+            
             # Add helper functions
-            h_file.write("// Function to get distance for a given position (exact match)\n")
-            h_file.write("float getDistanceForPosition(float position) {\n")
-            h_file.write("    for (int i = 0; i < LOOKUP_TABLE_SIZE; i++) {\n")
-            h_file.write("        if (positions[i] == position) {\n")
-            h_file.write("            return distances[i];\n")
-            h_file.write("        }\n")
+            h_file.write("// Find the interpolation segment for a key (binary search)\n")
+            h_file.write("// Returns i in [0, size - 2] with keys[i] <= key < keys[i + 1]; keys outside\n")
+            h_file.write("// the table land in the first or last segment. keys[] must be sorted ascending.\n")
+            h_file.write("static inline int lookupBracketIndex(const float *keys, int size, float key) {\n")
+            h_file.write("    int base = 0;\n")
+            h_file.write("    int len = size - 1;\n")
+            h_file.write("    \n")
+            h_file.write("    while (len > 1) {\n")
+            h_file.write("        int half = len / 2;\n")
+            h_file.write("        base = (keys[base + half] <= key) ? base + half : base;\n")
+            h_file.write("        len -= half;\n")
             h_file.write("    }\n")
-            h_file.write("    return -1.0f; // Position not found\n")
+            h_file.write("    \n")
+            h_file.write("    return base;\n")
             h_file.write("}\n\n")
             
-            h_file.write("// Function to get nearest distance for a position (interpolated)\n")
-            h_file.write("float getNearestDistance(float position) {\n")
-            h_file.write("    if (LOOKUP_TABLE_SIZE == 0) return -1.0f;\n")
+            h_file.write("// Interpolate ys[] at x over sorted xs[]\n")
+            h_file.write("// Exact matches and out-of-range inputs are handled by clamping the segment\n")
+            h_file.write("// weight, so the table is only searched once.\n")
+            h_file.write("static inline float lookupInterpolate(const float *xs, const float *ys, int size, float x) {\n")
+            h_file.write("    if (size == 0) return -1.0f;\n")
+            h_file.write("    if (size == 1) return ys[0];\n")
             h_file.write("    \n")
-            h_file.write("    // Check for exact match first\n")
-            h_file.write("    for (int i = 0; i < LOOKUP_TABLE_SIZE; i++) {\n")
-            h_file.write("        if (positions[i] == position) {\n")
-            h_file.write("            return distances[i];\n")
-            h_file.write("        }\n")
-            h_file.write("    }\n")
+            h_file.write("    int i = lookupBracketIndex(xs, size, x);\n")
+            h_file.write("    float dx = xs[i + 1] - xs[i];\n")
+            h_file.write("    float t = (dx > 0.0f) ? (x - xs[i]) / dx : 0.0f;\n")
+            h_file.write("    t = (t < 0.0f) ? 0.0f : t;\n")
+            h_file.write("    t = (t > 1.0f) ? 1.0f : t;\n")
             h_file.write("    \n")
-            h_file.write("    // Find the two closest points for interpolation\n")
-            h_file.write("    if (position <= positions[0]) {\n")
-            h_file.write("        return distances[0]; // Return first value\n")
-            h_file.write("    }\n")
-            h_file.write("    if (position >= positions[LOOKUP_TABLE_SIZE - 1]) {\n")
-            h_file.write("        return distances[LOOKUP_TABLE_SIZE - 1]; // Return last value\n")
+            h_file.write("    // Weighted form returns ys[i] / ys[i + 1] exactly at t == 0 / t == 1\n")
+            h_file.write("    return ys[i] * (1.0f - t) + ys[i + 1] * t;\n")
+            h_file.write("}\n\n")
+            
+            h_file.write("// Function to get distance for a given position (exact match)\n")
+            h_file.write("float getDistanceForPosition(float position) {\n")
+            h_file.write("    if (LOOKUP_TABLE_SIZE == 1) {\n")
+            h_file.write("        return (positions[0] == position) ? distances[0] : -1.0f;\n")
             h_file.write("    }\n")
             h_file.write("    \n")
-            h_file.write("    // Linear interpolation between two points\n")
-            h_file.write("    for (int i = 0; i < LOOKUP_TABLE_SIZE - 1; i++) {\n")
-            h_file.write("        if (position > positions[i] && position < positions[i + 1]) {\n")
-            h_file.write("            float x1 = positions[i];\n")
-            h_file.write("            float y1 = distances[i];\n")
-            h_file.write("            float x2 = positions[i + 1];\n")
-            h_file.write("            float y2 = distances[i + 1];\n")
-            h_file.write("            \n")
-            h_file.write("            // Linear interpolation formula\n")
-            h_file.write("            float interpolated = y1 + (y2 - y1) * (position - x1) / (x2 - x1);\n")
-            h_file.write("            return interpolated;\n")
-            h_file.write("        }\n")
+            h_file.write("    int i = lookupBracketIndex(positions, LOOKUP_TABLE_SIZE, position);\n")
+            h_file.write("    if (positions[i] == position) {\n")
+            h_file.write("        return distances[i];\n")
             h_file.write("    }\n")
-            h_file.write("    \n")
-            h_file.write("    return -1.0f; // Should not reach here\n")
+            h_file.write("    if (positions[i + 1] == position) {\n")
+            h_file.write("        return distances[i + 1];\n")
+            h_file.write("    }\n")
+            h_file.write("    return -1.0f; // Position not found\n")
+            h_file.write("}\n\n")
+            
+            h_file.write("// Function to get nearest distance for a position (interpolated)\n")
+            h_file.write("float getNearestDistance(float position) {\n")
+            h_file.write("    return lookupInterpolate(positions, distances, LOOKUP_TABLE_SIZE, position);\n")
             h_file.write("}\n\n")
             
             h_file.write("// Function to get the closest position index in the lookup table\n")
             h_file.write("int getClosestPositionIndex(float position) {\n")
-            h_file.write("    int closest_index = 0;\n")
-            h_file.write("    float min_diff = (position > positions[0]) ? position - positions[0] : positions[0] - position;\n")
+            h_file.write("    if (LOOKUP_TABLE_SIZE == 1) return 0;\n")
             h_file.write("    \n")
-            h_file.write("    for (int i = 1; i < LOOKUP_TABLE_SIZE; i++) {\n")
-            h_file.write("        float diff = (position > positions[i]) ? position - positions[i] : positions[i] - position;\n")
-            h_file.write("        if (diff < min_diff) {\n")
-            h_file.write("            min_diff = diff;\n")
-            h_file.write("            closest_index = i;\n")
-            h_file.write("        }\n")
-            h_file.write("    }\n")
+            h_file.write("    int i = lookupBracketIndex(positions, LOOKUP_TABLE_SIZE, position);\n")
+            h_file.write("    float diff_lo = (position > positions[i]) ? position - positions[i] : positions[i] - position;\n")
+            h_file.write("    float diff_hi = (position > positions[i + 1]) ? position - positions[i + 1] : positions[i + 1] - position;\n")
             h_file.write("    \n")
-            h_file.write("    return closest_index;\n")
+            h_file.write("    return (diff_hi < diff_lo) ? i + 1 : i;\n")
             h_file.write("}\n\n")
             
             h_file.write("// Function to get the nearest position given a distance (reverse lookup)\n")
+            h_file.write("// Searches the sorted inverse table, so non-monotonic sensor error is handled\n")
             h_file.write("float getNearestPosition(float distance) {\n")
-            h_file.write("    if (LOOKUP_TABLE_SIZE == 0) return -1.0f;\n")
-            h_file.write("    \n")
-            h_file.write("    // Check for exact match first\n")
-            h_file.write("    for (int i = 0; i < LOOKUP_TABLE_SIZE; i++) {\n")
-            h_file.write("        if (distances[i] == distance) {\n")
-            h_file.write("            return positions[i];\n")
-            h_file.write("        }\n")
-            h_file.write("    }\n")
-            h_file.write("    \n")
-            h_file.write("    // Find the two closest distances for interpolation\n")
-            h_file.write("    if (distance <= distances[0]) {\n")
-            h_file.write("        return positions[0]; // Return first position\n")
-            h_file.write("    }\n")
-            h_file.write("    if (distance >= distances[LOOKUP_TABLE_SIZE - 1]) {\n")
-            h_file.write("        return positions[LOOKUP_TABLE_SIZE - 1]; // Return last position\n")
-            h_file.write("    }\n")
-            h_file.write("    \n")
-            h_file.write("    // Linear interpolation between two points using distance as input\n")
-            h_file.write("    for (int i = 0; i < LOOKUP_TABLE_SIZE - 1; i++) {\n")
-            h_file.write("        if (distance > distances[i] && distance < distances[i + 1]) {\n")
-            h_file.write("            float x1 = distances[i];    // distance1\n")
-            h_file.write("            float y1 = positions[i];    // position1\n")
-            h_file.write("            float x2 = distances[i + 1]; // distance2\n")
-            h_file.write("            float y2 = positions[i + 1]; // position2\n")
-            h_file.write("            \n")
-            h_file.write("            // Linear interpolation formula (reverse lookup)\n")
-            h_file.write("            float interpolated = y1 + (y2 - y1) * (distance - x1) / (x2 - x1);\n")
-            h_file.write("            return interpolated;\n")
-            h_file.write("        }\n")
-            h_file.write("    }\n")
-            h_file.write("    \n")
-            h_file.write("    return -1.0f; // Should not reach here\n")
+            h_file.write("    if (distance <= INVERSE_DISTANCE_MIN) return inverse_positions[0];\n")
+            h_file.write("    if (distance >= INVERSE_DISTANCE_MAX) return inverse_positions[INVERSE_TABLE_SIZE - 1];\n")
+            h_file.write("    return lookupInterpolate(inverse_distances, inverse_positions, INVERSE_TABLE_SIZE, distance);\n")
             h_file.write("}\n\n")
             
             h_file.write("// Function to get the closest distance index in the lookup table (reverse search)\n")
@@ -807,7 +879,7 @@ class SensorComparison:
     
     def save_performance_log(self):
         """Save performance timing data to CSV file"""
-        has_data = any(len(self.performance_data[tid]['avg']) > 0 for tid in range(12))
+        has_data = any(len(self.performance_data[tid]['avg']) > 0 for tid in self.timer_names)
         if not has_data:
             return
         
@@ -819,7 +891,7 @@ class SensorComparison:
             writer = csv.writer(file)
             writer.writerow(["Timer ID", "Timer Name", "Avg (us)", "Max (us)", "Min (us)", "System Timestamp"])
             
-            for timer_id in range(12):
+            for timer_id in self.timer_names:
                 if len(self.performance_data[timer_id]['avg']) > 0:
                     timer_name = self.timer_names[timer_id]
                     for i in range(len(self.performance_data[timer_id]['avg'])):
@@ -0,0 +1,46 @@
+// Adaptive Sweep Window
+// Window selection around the tracked target, see sweep_window.h.
+
+#include "sweep_window.h"
+
+void sweep_window_full(const PrintDataConfig *print_data_config, SweepWindow *window)
+{
+        window->start_point = print_data_config->start_point;
+        window->num_points  = print_data_config->num_points;
+}
+
+bool sweep_window_next(const PrintDataConfig *full, const SweepWindow *current,
+                       bool locked, int32_t target_point, SweepWindow *next)
+{
+        int32_t step = (full->step > 0) ? full->step : 1;
+        int32_t size = 2 * (int32_t)SWEEP_WINDOW_HALF_WIDTH + 1;
+
+        if (!locked || full->num_points <= size)
+        {
+                sweep_window_full(full, next);
+        }
+        else
+        {
+                int32_t bin      = (target_point - current->start_point) / step;
+                bool    narrowed = (current->num_points < full->num_points);
+                bool    centred  = (bin >= (int32_t)SWEEP_WINDOW_EDGE_BINS) &&
+                                   (bin < (int32_t)current->num_points - (int32_t)SWEEP_WINDOW_EDGE_BINS);
+
+                if (narrowed && centred)
+                {
+                        *next = *current;
+                }
+                else
+                {
+                        // First bin of the new window on the full range's grid, kept inside it
+                        int32_t first = (target_point - full->start_point) / step - (int32_t)SWEEP_WINDOW_HALF_WIDTH;
+                        first = (first < 0) ? 0 : first;
+                        first = (first > full->num_points - size) ? full->num_points - size : first;
+
+                        next->start_point = full->start_point + first * step;
+                        next->num_points  = (uint16_t)size;
+                }
+        }
+
+        return (next->start_point != current->start_point) || (next->num_points != current->num_points);
+}
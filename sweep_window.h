@@ -0,0 +1,47 @@
+// Adaptive Sweep Window
+// While a detector holds a lock on the target, the sensor only sweeps a window
+// of SWEEP_WINDOW_HALF_WIDTH points (in steps) on each side of it instead of
+// the configured range. This shortens the measurement and the acc_sensor_read()
+// payload. The window is re-centred when the target comes within
+// SWEEP_WINDOW_EDGE_BINS of either edge, and returns to the full range as soon
+// as the lock is lost.
+//
+// Windows stay on the step grid of the full range, so bin distances in a
+// window are the same as for the matching bins of the full sweep.
+//
+// Enabled at build time with ADAPTIVE_SWEEP_WINDOW; it needs a detector with a
+// target_point hook (algo 4).
+
+#ifndef SWEEP_WINDOW_H
+#define SWEEP_WINDOW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "print_data_config.h"
+#include "tracking_gate.h"
+
+// Bins on each side of the target; must leave room for the tracking gate
+#ifndef SWEEP_WINDOW_HALF_WIDTH
+#define SWEEP_WINDOW_HALF_WIDTH (32U)
+#endif
+
+#ifndef SWEEP_WINDOW_EDGE_BINS
+#define SWEEP_WINDOW_EDGE_BINS (TRACKING_GATE_HALF_WIDTH)
+#endif
+
+typedef struct
+{
+        int32_t  start_point;
+        uint16_t num_points;
+} SweepWindow;
+
+// The full range of the configuration
+void sweep_window_full(const PrintDataConfig *print_data_config, SweepWindow *window);
+
+// Window for the next frame. full is the configured range, current the window
+// swept now. Returns true when next differs from current.
+bool sweep_window_next(const PrintDataConfig *full, const SweepWindow *current,
+                       bool locked, int32_t target_point, SweepWindow *next);
+
+#endif // SWEEP_WINDOW_H
@@ -0,0 +1,80 @@
+// Telemetry Burst
+// Several results per CAN FD frame, see telemetry_burst.h.
+
+#include "telemetry_burst.h"
+
+#include <string.h>
+
+#include "can_tx_queue.h"
+
+#if TELEMETRY_BURST_SAMPLES < 1 || TELEMETRY_BURST_SAMPLES > TELEMETRY_BURST_MAX_SAMPLES
+#error "TELEMETRY_BURST_SAMPLES must be 1 to TELEMETRY_BURST_MAX_SAMPLES"
+#endif
+
+void telemetry_burst_reset(TelemetryBurst *burst)
+{
+        memset(burst, 0, sizeof(*burst));
+}
+
+bool telemetry_burst_flush(TelemetryBurst *burst)
+{
+        if (burst->count == 0)
+        {
+                return true;
+        }
+
+        uint8_t *data = burst->data;
+
+        data[0] = (burst->base_tick >> 24) & 0xFF;
+        data[1] = (burst->base_tick >> 16) & 0xFF;
+        data[2] = (burst->base_tick >> 8) & 0xFF;
+        data[3] = burst->base_tick & 0xFF;
+        data[4] = (burst->sequence >> 8) & 0xFF;
+        data[5] = burst->sequence & 0xFF;
+        data[6] = burst->count;
+        data[7] = 0;
+
+        // Unused sample slots go out as zeros
+        memset(&data[TELEMETRY_BURST_HEADER + burst->count * TELEMETRY_BURST_SAMPLE_BYTES], 0,
+               (TELEMETRY_BURST_MAX_SAMPLES - burst->count) * TELEMETRY_BURST_SAMPLE_BYTES);
+
+        bool sent = can_tx_queue_send_fd(TELEMETRY_BURST_CAN_ID, data, TELEMETRY_BURST_LENGTH);
+
+        burst->sequence++;
+        burst->count = 0;
+        return sent;
+}
+
+bool telemetry_burst_add(TelemetryBurst *burst, uint32_t distance, int16_t temp, uint32_t tick)
+{
+        bool sent = true;
+
+        if (burst->count > 0 && (tick - burst->base_tick) > UINT16_MAX)
+        {
+                sent = telemetry_burst_flush(burst);
+        }
+        if (burst->count == 0)
+        {
+                burst->base_tick = tick;
+        }
+
+        uint16_t delta = (uint16_t)(tick - burst->base_tick);
+        int8_t   temp8 = (temp > INT8_MAX) ? INT8_MAX : (temp < INT8_MIN) ? INT8_MIN : (int8_t)temp;
+        uint8_t  *out  = &burst->data[TELEMETRY_BURST_HEADER + burst->count * TELEMETRY_BURST_SAMPLE_BYTES];
+
+        distance = (distance > 0xFFFFFFU) ? 0xFFFFFFU : distance;
+
+        out[0] = (distance >> 16) & 0xFF;
+        out[1] = (distance >> 8) & 0xFF;
+        out[2] = distance & 0xFF;
+        out[3] = (uint8_t)temp8;
+        out[4] = (delta >> 8) & 0xFF;
+        out[5] = delta & 0xFF;
+        burst->count++;
+
+        if (burst->count >= TELEMETRY_BURST_SAMPLES)
+        {
+                sent = telemetry_burst_flush(burst) && sent;
+        }
+        return sent;
+}
@@ -0,0 +1,51 @@
+// Telemetry Burst
+// At high frame rates one CAN frame per result spends most of the bus on
+// arbitration and the receiver on interrupts. In burst mode (CAN_FD_BURST)
+// TELEMETRY_BURST_SAMPLES consecutive results are collected and sent as one
+// 64-byte CAN FD frame (big-endian):
+//   0x16 BURST  sensor -> host  base tick (u32, ms), burst sequence (u16),
+//                               sample count (u8), reserved (u8), then per
+//                               sample: distance (u24, 0.1 mm, as on 0x13),
+//                               temperature (i8, degrees C), tick - base tick
+//                               (u16, ms)
+// The base tick is the tick of the first sample. A burst is sent early, with
+// fewer samples, when the next sample would be more than 65535 ms after it,
+// and acc_service() flushes it on recalibration and when the sweep window or
+// the detector changes the sensor config, so one burst never mixes settings.
+// A gap in the burst sequence on the host is a dropped burst.
+
+#ifndef TELEMETRY_BURST_H
+#define TELEMETRY_BURST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TELEMETRY_BURST_CAN_ID       (0x16U)
+#define TELEMETRY_BURST_LENGTH       (64U)
+#define TELEMETRY_BURST_HEADER       (8U)
+#define TELEMETRY_BURST_SAMPLE_BYTES (6U)
+#define TELEMETRY_BURST_MAX_SAMPLES  ((TELEMETRY_BURST_LENGTH - TELEMETRY_BURST_HEADER) / TELEMETRY_BURST_SAMPLE_BYTES)
+
+// Samples per burst, at most TELEMETRY_BURST_MAX_SAMPLES (9)
+#ifndef TELEMETRY_BURST_SAMPLES
+#define TELEMETRY_BURST_SAMPLES TELEMETRY_BURST_MAX_SAMPLES
+#endif
+
+typedef struct
+{
+        uint8_t  data[TELEMETRY_BURST_LENGTH];
+        uint8_t  count;     // Samples in data
+        uint16_t sequence;  // Of the burst being filled
+        uint32_t base_tick; // Tick of its first sample
+} TelemetryBurst;
+
+void telemetry_burst_reset(TelemetryBurst *burst);
+
+// Add one result, sending the burst when it is full. distance is in 0.1 mm
+// and saturates at 0xFFFFFF. Returns false if a burst could not be queued.
+bool telemetry_burst_add(TelemetryBurst *burst, uint32_t distance, int16_t temp, uint32_t tick);
+
+// Send the samples collected so far, if any
+bool telemetry_burst_flush(TelemetryBurst *burst);
+
+#endif // TELEMETRY_BURST_H
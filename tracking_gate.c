@@ -0,0 +1,109 @@
+// Tracking Gate
+// Gated search window and hit/miss statistics, see tracking_gate.h.
+
+#include "tracking_gate.h"
+
+#include <string.h>
+
+#include "can_tx_queue.h"
+
+void tracking_gate_reset(TrackingGate *gate)
+{
+        memset(gate, 0, sizeof(*gate));
+}
+
+bool tracking_gate_window(const TrackingGate *gate, const PrintDataConfig *print_data_config,
+                          uint16_t *first_bin, uint16_t *end_bin)
+{
+        int32_t num_points = print_data_config->num_points;
+
+        if (!gate->locked)
+        {
+                *first_bin = 0;
+                *end_bin   = num_points;
+                return false;
+        }
+
+        int32_t step  = (print_data_config->step > 0) ? print_data_config->step : 1;
+        int32_t bin   = (gate->point - print_data_config->start_point) / step;
+        int32_t first = bin - (int32_t)TRACKING_GATE_HALF_WIDTH;
+        int32_t end   = bin + (int32_t)TRACKING_GATE_HALF_WIDTH + 1;
+
+        // A target outside the sweep gives an empty gate, which counts as a miss
+        first = (first < 0) ? 0 : first;
+        first = (first > num_points) ? num_points : first;
+        end   = (end > num_points) ? num_points : end;
+        end   = (end < first) ? first : end;
+
+        *first_bin = (uint16_t)first;
+        *end_bin   = (uint16_t)end;
+        return true;
+}
+
+static void send_stats(TrackingGate *gate)
+{
+        uint16_t bins = (uint16_t)(gate->bins_scanned / gate->frames);
+        uint8_t  data[8];
+
+        data[0] = (gate->hits >> 8) & 0xFF;
+        data[1] = gate->hits & 0xFF;
+        data[2] = (gate->gate_misses >> 8) & 0xFF;
+        data[3] = gate->gate_misses & 0xFF;
+        data[4] = (gate->full_scans >> 8) & 0xFF;
+        data[5] = gate->full_scans & 0xFF;
+        data[6] = (bins >> 8) & 0xFF;
+        data[7] = bins & 0xFF;
+
+        can_tx_queue_send(TRACKING_GATE_CAN_STATS, data);
+
+        gate->frames       = 0;
+        gate->hits         = 0;
+        gate->gate_misses  = 0;
+        gate->full_scans   = 0;
+        gate->bins_scanned = 0;
+}
+
+bool tracking_gate_update(TrackingGate *gate, const PrintDataConfig *print_data_config, bool gated,
+                          uint16_t first_bin, int32_t index, uint16_t bins_scanned)
+{
+        bool found;
+
+        gate->frames++;
+        gate->bins_scanned += bins_scanned;
+
+        if (gated)
+        {
+                // A crossing on the first gate bin started before the gate
+                found = (index > (int32_t)first_bin);
+                if (found)
+                {
+                        gate->hits++;
+                        gate->misses = 0;
+                }
+                else
+                {
+                        gate->gate_misses++;
+                        gate->misses++;
+                        gate->locked = (gate->misses < TRACKING_GATE_MAX_MISSES);
+                }
+        }
+        else
+        {
+                gate->full_scans++;
+                found        = (index > 0);
+                gate->locked = found;
+                gate->misses = 0;
+        }
+
+        if (found)
+        {
+                gate->point = print_data_config->start_point + index * (int32_t)print_data_config->step;
+        }
+
+        if (gate->frames >= TRACKING_GATE_REPORT_FRAMES)
+        {
+                send_stats(gate);
+        }
+
+        return found;
+}
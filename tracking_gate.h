@@ -0,0 +1,69 @@
+// Tracking Gate
+// Between frames the target moves a few bins at most, so once a crossing is
+// found the next frames only search a gate of bins around it. After
+// TRACKING_GATE_MAX_MISSES consecutive frames without a crossing inside the
+// gate the lock is dropped and the next frame scans the whole sweep again.
+//
+// The target is kept as an absolute sweep point (start_point + bin * step), so
+// the lock survives a change of start_point or num_points between frames.
+//
+// A gated frame only counts as a hit when the crossing is a rising edge inside
+// the gate (the first gate bin is below threshold), so a target that moved
+// closer than the gate is not mistaken for one inside it.
+//
+// Counters are sent every TRACKING_GATE_REPORT_FRAMES frames (classic CAN,
+// big-endian):
+//   0x604 GATE STATS  sensor -> host  hits (u16), misses (u16), full scans (u16),
+//                                     mean bins scanned per frame (u16)
+
+#ifndef TRACKING_GATE_H
+#define TRACKING_GATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "print_data_config.h"
+
+#define TRACKING_GATE_CAN_STATS (0x604U)
+
+// Bins searched on each side of the last crossing
+#ifndef TRACKING_GATE_HALF_WIDTH
+#define TRACKING_GATE_HALF_WIDTH (8U)
+#endif
+
+#ifndef TRACKING_GATE_MAX_MISSES
+#define TRACKING_GATE_MAX_MISSES (3U)
+#endif
+
+#ifndef TRACKING_GATE_REPORT_FRAMES
+#define TRACKING_GATE_REPORT_FRAMES (50U)
+#endif
+
+typedef struct
+{
+        bool     locked;
+        int32_t  point;  // Sweep point of the last hit
+        uint16_t misses; // Consecutive misses while locked
+
+        // Counts since the last report
+        uint16_t frames;
+        uint16_t hits;
+        uint16_t gate_misses;
+        uint16_t full_scans;
+        uint32_t bins_scanned;
+} TrackingGate;
+
+void tracking_gate_reset(TrackingGate *gate);
+
+// Bins of the sweep described by print_data_config to search this frame,
+// [*first_bin, *end_bin). Returns true when gated, false for a full scan.
+bool tracking_gate_window(const TrackingGate *gate, const PrintDataConfig *print_data_config,
+                          uint16_t *first_bin, uint16_t *end_bin);
+
+// Record the result of the search returned by tracking_gate_window(): the
+// crossing bin or -1, and how many bins were scanned. Returns true if the
+// crossing should be reported.
+bool tracking_gate_update(TrackingGate *gate, const PrintDataConfig *print_data_config, bool gated,
+                          uint16_t first_bin, int32_t index, uint16_t bins_scanned);
+
+#endif // TRACKING_GATE_H